@@ -0,0 +1,269 @@
+#include "async_writer.h"
+#include "latency_stats.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// AsyncWriter Implementation
+AsyncWriter::~AsyncWriter() {
+    close();
+}
+
+bool AsyncWriter::open(const std::string& filename, const Options& options) {
+    close();
+
+    // Resuming keeps the partial last block of the kept bytes in the first
+    // buffer and rewrites it from its aligned start, which O_DIRECT requires
+    uint64_t keep = options.keep_bytes;
+    uint64_t keep_start = keep / ALIGNMENT * ALIGNMENT;
+    std::vector<char> tail(keep - keep_start);
+    if (keep > 0) {
+        int reader = ::open(filename.c_str(), O_RDONLY);
+        struct stat st;
+        bool ok = reader >= 0 && fstat(reader, &st) == 0 && static_cast<uint64_t>(st.st_size) >= keep &&
+                  ::pread(reader, tail.data(), tail.size(), static_cast<off_t>(keep_start)) ==
+                      static_cast<ssize_t>(tail.size());
+        if (reader >= 0) {
+            ::close(reader);
+        }
+        if (!ok) {
+            return false;
+        }
+    }
+
+    // Buffers first, so that a failed allocation leaves the file untouched
+    buffer_size = (std::max<size_t>(options.buffer_size, 1) + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+    size_t count = std::max<size_t>(options.buffer_count, 2);
+    full_buffers.reset(new SpscQueue<Buffer>(count));
+    free_buffers.reset(new SpscQueue<char*>(count));
+    bool allocated = writer_waiter.open();
+    for (size_t i = 0; allocated && i < count; ++i) {
+        char* buffer = static_cast<char*>(std::aligned_alloc(ALIGNMENT, buffer_size));
+        allocated = buffer != nullptr;
+        if (buffer) {
+            storage.push_back(buffer);
+        }
+    }
+    if (!allocated) {
+        releaseBuffers();
+        return false;
+    }
+
+    int flags = O_WRONLY | O_CREAT | (keep > 0 ? 0 : O_TRUNC);
+    fd = -1;
+    if (options.direct_io) {
+        fd = ::open(filename.c_str(), flags | O_DIRECT, 0644);
+    }
+    direct = fd >= 0;
+    if (fd < 0) {
+        fd = ::open(filename.c_str(), flags, 0644);
+    }
+    if (fd >= 0 && keep > 0 &&
+        (ftruncate(fd, static_cast<off_t>(keep)) != 0 || ::lseek(fd, static_cast<off_t>(keep_start), SEEK_SET) < 0)) {
+        ::close(fd);
+        fd = -1;
+    }
+    if (fd < 0) {
+        releaseBuffers();
+        return false;
+    }
+
+    for (size_t i = 1; i < count; ++i) {
+        free_buffers->tryPush(storage[i]);
+    }
+    current = storage[0];
+    std::memcpy(current, tail.data(), tail.size());
+    used = tail.size();
+    flushed = used;
+    bytes = keep;
+    stalls = 0;
+    buffers_written = 0;
+    buffers_submitted = 0;
+    stopping = false;
+    failed = false;
+
+    writer = std::thread(&AsyncWriter::writerLoop, this);
+    return true;
+}
+
+void AsyncWriter::releaseBuffers() {
+    for (char* buffer : storage) {
+        std::free(buffer);
+    }
+    storage.clear();
+    full_buffers.reset();
+    free_buffers.reset();
+    writer_waiter.close();
+    current = nullptr;
+    used = 0;
+    flushed = 0;
+    buffer_size = 0;
+}
+
+void AsyncWriter::appendSlow(const char* data, size_t length) {
+    while (length > 0) {
+        size_t chunk = std::min(length, buffer_size - used);
+        std::memcpy(current + used, data, chunk);
+        used += chunk;
+        bytes += chunk;
+        data += chunk;
+        length -= chunk;
+        if (used == buffer_size) {
+            submit(true);
+        }
+    }
+}
+
+// Hand the current buffer to the writer and, if take_next, wait for a free one
+void AsyncWriter::submit(bool take_next) {
+    // The full queue holds every buffer, so this push cannot fail
+    full_buffers->tryPush(Buffer{current, used});
+    writer_waiter.wake();
+    buffers_submitted++;
+    current = nullptr;
+    used = 0;
+    flushed = 0;
+    if (!take_next) {
+        return;
+    }
+
+    unsigned attempts = 0;
+    if (!free_buffers->tryPop(current)) {
+        stalls++;
+        while (!free_buffers->tryPop(current)) {
+            backoff(attempts);
+        }
+    }
+}
+
+// Write at the file position, or at offset without moving it
+bool AsyncWriter::writeBuffer(const Buffer& buffer, int64_t offset) {
+    LATENCY_STAGE(Write);
+    size_t length = buffer.length;
+    if (direct) {
+        // O_DIRECT writes whole blocks; close() trims the padding
+        size_t padded = (length + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+        std::memset(buffer.data + length, 0, padded - length);
+        length = padded;
+    }
+
+    const char* p = buffer.data;
+    while (length > 0) {
+        ssize_t n = offset < 0 ? ::write(fd, p, length) : ::pwrite(fd, p, length, static_cast<off_t>(offset));
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EINVAL && direct) {
+                // Filesystem rejects O_DIRECT writes: continue buffered
+                fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) & ~O_DIRECT);
+                direct = false;
+                continue;
+            }
+            return false;
+        }
+        p += n;
+        length -= static_cast<size_t>(n);
+        if (offset >= 0) {
+            offset += n;
+        }
+    }
+    return true;
+}
+
+void AsyncWriter::writerLoop() {
+    unsigned attempts = 0;
+    for (;;) {
+        Buffer buffer;
+        bool have = full_buffers->tryPop(buffer);
+        if (!have && stopping.load(std::memory_order_acquire)) {
+            // Everything submitted before stopping was set is already queued
+            if (!full_buffers->tryPop(buffer)) {
+                return;
+            }
+            have = true;
+        }
+        if (!have) {
+            if (attempts < IDLE_SPIN_ATTEMPTS) {
+                spinWait(attempts);
+                continue;
+            }
+            // Idle: block until submit() or close() wakes the writer
+            writer_waiter.park([&]() {
+                have = full_buffers->tryPop(buffer);
+                return have || stopping.load(std::memory_order_acquire);
+            });
+            attempts = 0;
+            if (!have) {
+                continue;
+            }
+        }
+        attempts = 0;
+        if (!failed && !writeBuffer(buffer)) {
+            failed = true;  // Keep recycling buffers so the caller never blocks
+        }
+        buffers_written++;
+        free_buffers->tryPush(buffer.data);
+    }
+}
+
+bool AsyncWriter::flush() {
+    if (fd < 0) {
+        return false;
+    }
+
+    unsigned attempts = 0;
+    while (buffers_written.load(std::memory_order_acquire) != buffers_submitted) {
+        backoff(attempts);
+    }
+
+    // The writer is idle and its file position is where the current buffer
+    // starts: write what was appended since the last flush (from its block
+    // start under O_DIRECT) without moving the position, so the full buffer
+    // later simply overwrites it
+    size_t start = direct ? flushed / ALIGNMENT * ALIGNMENT : flushed;
+    if (used > start && !failed &&
+        !writeBuffer(Buffer{current + start, used - start}, static_cast<int64_t>(bytes - used + start))) {
+        failed = true;
+    }
+    flushed = used;
+    return !failed;
+}
+
+bool AsyncWriter::close() {
+    if (fd < 0) {
+        return false;
+    }
+
+    if (used > 0) {
+        submit(false);
+    }
+    stopping.store(true, std::memory_order_release);
+    writer_waiter.wake();
+    writer.join();
+
+    bool ok = !failed;
+    if (ok && ftruncate(fd, static_cast<off_t>(bytes)) != 0) {
+        ok = false;  // Drops the O_DIRECT padding of the last block
+    }
+    if (::close(fd) != 0) {
+        ok = false;
+    }
+    fd = -1;
+
+    releaseBuffers();
+    return ok;
+}
+
+AsyncWriter::Stats AsyncWriter::stats() const {
+    Stats result;
+    result.bytes = bytes;
+    result.buffers_written = buffers_written;
+    result.stalls = stalls;
+    result.direct_io = direct;
+    return result;
+}
@@ -0,0 +1,106 @@
+#ifndef ASYNC_WRITER_H
+#define ASYNC_WRITER_H
+
+#include "spsc_queue.h"
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+// Output file written by a dedicated thread.
+//
+// The caller appends bytes into the current page-aligned buffer. A full
+// buffer goes to the writer thread through a lock-free SPSC queue and the
+// caller continues in a free buffer returned by the writer through a second
+// queue. When every buffer is waiting to be written the caller stalls
+// (backpressure) until one comes back; stalls are counted in stats(). With
+// direct_io the file is opened with O_DIRECT where the filesystem allows it.
+// With keep_bytes an existing file is cut to that length and appended to.
+// An idle writer thread spins briefly and then blocks until the next buffer.
+class AsyncWriter {
+public:
+    struct Options {
+        size_t buffer_size = 1 << 20;  // rounded up to a multiple of 4096
+        size_t buffer_count = 4;
+        bool direct_io = false;
+        uint64_t keep_bytes = 0;       // resume after this many bytes of the existing file
+    };
+
+    struct Stats {
+        uint64_t bytes = 0;            // bytes appended, kept bytes included
+        uint64_t buffers_written = 0;
+        uint64_t stalls = 0;           // appends that waited for a free buffer
+        bool direct_io = false;        // O_DIRECT actually in use
+    };
+
+private:
+    struct Buffer {
+        char* data;
+        size_t length;
+    };
+
+    static constexpr size_t ALIGNMENT = 4096;
+    static constexpr unsigned IDLE_SPIN_ATTEMPTS = 256;  // before an idle writer parks
+
+    int fd = -1;
+    size_t buffer_size = 0;
+    std::vector<char*> storage;
+    std::unique_ptr<SpscQueue<Buffer>> full_buffers;  // caller -> writer
+    std::unique_ptr<SpscQueue<char*>> free_buffers;  // writer -> caller
+    char* current = nullptr;
+    size_t used = 0;
+    size_t flushed = 0;  // bytes of current already in the file
+
+    std::thread writer;
+    std::atomic<bool> stopping{false};
+    std::atomic<bool> failed{false};
+    std::atomic<bool> direct{false};
+    RingWaiter writer_waiter;  // submit() and close() wake a parked writer
+    std::atomic<uint64_t> buffers_written{0};
+    uint64_t buffers_submitted = 0;
+    uint64_t bytes = 0;
+    uint64_t stalls = 0;
+
+    void submit(bool take_next);
+    void releaseBuffers();
+    void appendSlow(const char* data, size_t length);
+    void writerLoop();
+    bool writeBuffer(const Buffer& buffer, int64_t offset = -1);
+
+public:
+    AsyncWriter() = default;
+    ~AsyncWriter();
+
+    AsyncWriter(const AsyncWriter&) = delete;
+    AsyncWriter& operator=(const AsyncWriter&) = delete;
+
+    bool open(const std::string& filename, const Options& options);
+    bool open(const std::string& filename) { return open(filename, Options()); }
+
+    void append(const char* data, size_t length) {
+        if (length <= buffer_size - used) {
+            std::memcpy(current + used, data, length);
+            used += length;
+            bytes += length;
+            return;
+        }
+        appendSlow(data, length);
+    }
+    void append(std::string_view text) { append(text.data(), text.size()); }
+
+    // Wait until everything appended so far is in the file; appending can
+    // continue afterwards. False if any write failed.
+    bool flush();
+
+    // Flush, stop the writer thread and close; false if any write failed
+    bool close();
+
+    bool isOpen() const { return fd >= 0; }
+    Stats stats() const;
+};
+
+#endif // ASYNC_WRITER_H
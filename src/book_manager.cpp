@@ -0,0 +1,84 @@
+#include "book_manager.h"
+
+// BookManager Implementation
+BookManager::BookManager(int64_t tick) : tick_size(tick) {
+    index.assign(64, IndexSlot{0, EMPTY_SLOT});
+    index_mask = index.size() - 1;
+}
+
+void BookManager::growIndex() {
+    std::vector<IndexSlot> old;
+    old.swap(index);
+    index.assign(old.size() * 2, IndexSlot{0, EMPTY_SLOT});
+    index_mask = index.size() - 1;
+
+    for (const IndexSlot& slot : old) {
+        if (slot.entry == EMPTY_SLOT) continue;
+        size_t pos = slotFor(slot.key);
+        while (index[pos].entry != EMPTY_SLOT) {
+            pos = (pos + 1) & index_mask;
+        }
+        index[pos] = slot;
+    }
+}
+
+BookEntry* BookManager::find(int publisher_id, int instrument_id) {
+    uint64_t key = makeKey(publisher_id, instrument_id);
+    if (last_entry && last_key == key) {
+        return last_entry;
+    }
+
+    for (size_t pos = slotFor(key);; pos = (pos + 1) & index_mask) {
+        const IndexSlot& slot = index[pos];
+        if (slot.entry == EMPTY_SLOT) {
+            return nullptr;
+        }
+        if (slot.key == key) {
+            last_key = key;
+            last_entry = &entries[slot.entry];
+            return last_entry;
+        }
+    }
+}
+
+BookEntry& BookManager::route(int publisher_id, int instrument_id, uint32_t symbol_id) {
+    if (BookEntry* entry = find(publisher_id, instrument_id)) {
+        return *entry;
+    }
+
+    // Keep the index at most half full
+    if ((entries.size() + 1) * 2 > index.size()) {
+        growIndex();
+    }
+
+    uint64_t key = makeKey(publisher_id, instrument_id);
+    entries.emplace_back(static_cast<uint32_t>(entries.size()), static_cast<uint16_t>(publisher_id),
+                         static_cast<uint32_t>(instrument_id), symbol_id, tick_size);
+    if (view_depth != BOOK_DEPTH) {
+        entries.back().book.setViewDepth(view_depth);
+    }
+
+    size_t pos = slotFor(key);
+    while (index[pos].entry != EMPTY_SLOT) {
+        pos = (pos + 1) & index_mask;
+    }
+    index[pos] = IndexSlot{key, static_cast<uint32_t>(entries.size() - 1)};
+
+    last_key = key;
+    last_entry = &entries.back();
+    return entries.back();
+}
+
+void BookManager::setViewDepth(int depth) {
+    view_depth = depth;
+    for (BookEntry& entry : entries) {
+        entry.book.setViewDepth(depth);
+    }
+}
+
+void BookManager::clear() {
+    entries.clear();
+    index.assign(64, IndexSlot{0, EMPTY_SLOT});
+    index_mask = index.size() - 1;
+    last_entry = nullptr;
+}
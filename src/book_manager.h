@@ -0,0 +1,83 @@
+#ifndef BOOK_MANAGER_H
+#define BOOK_MANAGER_H
+
+#include "orderbook.h"
+#include "mbp_formatter.h"
+#include "symbol_table.h"
+#include <deque>
+#include <vector>
+
+// One instrument's book with its own incremental MBP-10 row formatter
+struct BookEntry {
+    uint32_t index;  // creation order, for per-book state kept outside the entry
+    uint16_t publisher_id;
+    uint32_t instrument_id;
+    uint32_t symbol_id;
+    OrderBook book;
+    MBPFormatter formatter;
+
+    BookEntry(uint32_t entry_index, uint16_t publisher, uint32_t instrument, uint32_t symbol, int64_t tick_size)
+        : index(entry_index), publisher_id(publisher), instrument_id(instrument), symbol_id(symbol), book(tick_size) {}
+};
+
+// Routes each record to the OrderBook of its (publisher_id, instrument_id).
+//
+// Books live in a deque (chunked, never moved, so references stay valid) and
+// are found through a flat linear-probing index. Consecutive records for the
+// same instrument hit a one-entry cache before the index.
+class BookManager {
+private:
+    struct IndexSlot {
+        uint64_t key;
+        uint32_t entry;  // EMPTY_SLOT when unused
+    };
+
+    static constexpr uint32_t EMPTY_SLOT = 0xFFFFFFFFu;
+
+    int64_t tick_size;
+    int view_depth = BOOK_DEPTH;
+    std::deque<BookEntry> entries;
+    std::vector<IndexSlot> index;
+    size_t index_mask = 0;
+
+    uint64_t last_key = 0;
+    BookEntry* last_entry = nullptr;
+
+    static uint64_t makeKey(int publisher_id, int instrument_id) {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(publisher_id)) << 32) |
+               static_cast<uint32_t>(instrument_id);
+    }
+
+    size_t slotFor(uint64_t key) const {
+        return static_cast<size_t>((key * 0x9E3779B97F4A7C15ULL) >> 32) & index_mask;
+    }
+
+    void growIndex();
+
+public:
+    explicit BookManager(int64_t tick = DEFAULT_TICK_SIZE);
+
+    // Book for the record's instrument, created on first use
+    BookEntry& route(const MBORecord& record) {
+        return route(record.publisher_id, record.instrument_id, record.symbol_id);
+    }
+    BookEntry& route(int publisher_id, int instrument_id, uint32_t symbol_id);
+
+    // Existing book or nullptr
+    BookEntry* find(int publisher_id, int instrument_id);
+
+    size_t size() const { return entries.size(); }
+
+    // View depth of every book, current and future (see OrderBook::setViewDepth)
+    void setViewDepth(int depth);
+    const SymbolTable& symbols() const { return SymbolTable::global(); }
+
+    std::deque<BookEntry>::iterator begin() { return entries.begin(); }
+    std::deque<BookEntry>::iterator end() { return entries.end(); }
+    std::deque<BookEntry>::const_iterator begin() const { return entries.begin(); }
+    std::deque<BookEntry>::const_iterator end() const { return entries.end(); }
+
+    void clear();
+};
+
+#endif // BOOK_MANAGER_H
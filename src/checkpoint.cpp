@@ -0,0 +1,140 @@
+#include "checkpoint.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+namespace {
+
+template <typename T>
+void writeRaw(std::ostream& out, const T& value) {
+    out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template <typename T>
+bool readRaw(std::istream& in, T& value) {
+    return static_cast<bool>(in.read(reinterpret_cast<char*>(&value), sizeof(value)));
+}
+
+} // namespace
+
+bool writeCheckpoint(std::ostream& out, const BookManager& books, const CheckpointPosition& position) {
+    CheckpointHeader header{};
+    std::memcpy(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic));
+    header.version = CHECKPOINT_VERSION;
+    header.book_count = static_cast<uint32_t>(books.size());
+    header.records = position.records;
+    header.input_offset = position.input_offset;
+    header.ts_recv = position.ts_recv;
+    header.sequence = position.sequence;
+    header.output_count = static_cast<uint32_t>(position.outputs.size());
+    header.tracker_size = sizeof(TradeSequenceTracker);
+    header.changes_only = position.changes_only ? 1 : 0;
+    writeRaw(out, header);
+    for (const CheckpointOutput& output : position.outputs) {
+        writeRaw(out, output);
+    }
+
+    std::vector<CheckpointOrder> orders;
+    for (const BookEntry& entry : books) {
+        orders.clear();
+        entry.book.forEachOrder([&orders](const Order& order) {
+            CheckpointOrder saved{};
+            saved.order_id = order.order_id;
+            saved.price = order.price;
+            saved.size = order.size;
+            saved.side = order.side;
+            orders.push_back(saved);
+        });
+        // Table order is hash order, and reinserting keys in hash order into a
+        // growing Robin Hood table builds long probe runs; order ids are not
+        std::sort(orders.begin(), orders.end(),
+                  [](const CheckpointOrder& a, const CheckpointOrder& b) { return a.order_id < b.order_id; });
+
+        const std::string& symbol = books.symbols().name(entry.symbol_id);
+        CheckpointBook book{};
+        book.instrument_id = entry.instrument_id;
+        book.publisher_id = entry.publisher_id;
+        book.symbol_length = static_cast<uint16_t>(std::min<size_t>(symbol.size(), UINT16_MAX));
+        book.order_count = orders.size();
+        writeRaw(out, book);
+        out.write(symbol.data(), book.symbol_length);
+        out.write(reinterpret_cast<const char*>(orders.data()), orders.size() * sizeof(CheckpointOrder));
+        writeRaw(out, entry.book.tradeSequences());
+    }
+    return static_cast<bool>(out);
+}
+
+bool writeCheckpoint(const std::string& filename, const BookManager& books, const CheckpointPosition& position) {
+    std::string temporary = filename + ".tmp";
+    std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+        return false;
+    }
+
+    writeCheckpoint(out, books, position);
+    out.close();
+    if (!out) {
+        std::remove(temporary.c_str());
+        return false;
+    }
+    return std::rename(temporary.c_str(), filename.c_str()) == 0;
+}
+
+bool readCheckpoint(std::istream& in, BookManager& books, CheckpointPosition& position) {
+    // Bytes left in the stream bound the counts read from it
+    std::streampos start = in.tellg();
+    in.seekg(0, std::ios::end);
+    uint64_t file_size = static_cast<uint64_t>(in.tellg() - start);
+    in.seekg(start);
+
+    CheckpointHeader header;
+    if (!readRaw(in, header) || std::memcmp(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != CHECKPOINT_VERSION || header.tracker_size != sizeof(TradeSequenceTracker) ||
+        header.output_count > file_size / sizeof(CheckpointOutput)) {
+        return false;
+    }
+
+    position = CheckpointPosition();
+    position.records = header.records;
+    position.input_offset = header.input_offset;
+    position.ts_recv = header.ts_recv;
+    position.sequence = header.sequence;
+    position.changes_only = header.changes_only != 0;
+    position.outputs.resize(header.output_count);
+    for (CheckpointOutput& output : position.outputs) {
+        if (!readRaw(in, output)) return false;
+    }
+
+    books.clear();
+    std::vector<CheckpointOrder> orders;
+    std::string symbol;
+    TradeSequenceTracker trades;
+    for (uint32_t i = 0; i < header.book_count; ++i) {
+        CheckpointBook book;
+        if (!readRaw(in, book) || book.order_count > file_size / sizeof(CheckpointOrder)) {
+            return false;
+        }
+        symbol.resize(book.symbol_length);
+        orders.resize(book.order_count);
+        if (!in.read(symbol.data(), symbol.size()) ||
+            !in.read(reinterpret_cast<char*>(orders.data()), orders.size() * sizeof(CheckpointOrder)) ||
+            !readRaw(in, trades)) {
+            return false;
+        }
+
+        BookEntry& entry = books.route(book.publisher_id, static_cast<int>(book.instrument_id),
+                                       SymbolTable::global().intern(symbol));
+        entry.book.reserveOrders(orders.size());
+        for (const CheckpointOrder& saved : orders) {
+            entry.book.restoreOrder(Order(saved.order_id, saved.price, saved.size, saved.side));
+        }
+        entry.book.restoreTradeSequences(trades);
+    }
+    return true;
+}
+
+bool readCheckpoint(const std::string& filename, BookManager& books, CheckpointPosition& position) {
+    std::ifstream in(filename, std::ios::binary);
+    return in.is_open() && readCheckpoint(in, books, position);
+}
@@ -0,0 +1,91 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include "book_manager.h"
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// Binary checkpoint of every book plus the replay position it was taken at.
+//
+// Layout: a 64-byte CheckpointHeader, output_count CheckpointOutputs, then
+// per book a CheckpointBook, its symbol name, order_count CheckpointOrders
+// and the raw TradeSequenceTracker. Price levels and top views are not
+// stored: they are rebuilt from the orders on load. The tracker is copied in
+// host layout, so a checkpoint is only read back by the build that wrote it
+// (the header records the tracker size to catch mismatches).
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "checkpoint format assumes a little-endian host");
+static_assert(std::is_trivially_copyable<TradeSequenceTracker>::value, "trade tracker is checkpointed as raw bytes");
+
+constexpr char CHECKPOINT_MAGIC[8] = {'M', 'B', 'O', 'C', 'K', 'P', 'T', '\0'};
+constexpr uint32_t CHECKPOINT_VERSION = 1;
+
+// input_offset when the replay read no seekable input (records were parsed up front)
+constexpr uint64_t NO_INPUT_OFFSET = UINT64_MAX;
+
+struct CheckpointHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t book_count;
+    uint64_t records;       // input records applied
+    uint64_t input_offset;  // MBOReader::position() of the next record
+    int64_t ts_recv;        // last applied record
+    uint32_t sequence;
+    uint32_t output_count;
+    uint32_t tracker_size;  // sizeof(TradeSequenceTracker)
+    uint8_t changes_only;
+    uint8_t reserved[11];
+};
+
+struct CheckpointOutput {
+    uint32_t depth;
+    uint32_t reserved;
+    uint64_t rows;   // rows written
+    uint64_t bytes;  // output file length, header included
+};
+
+struct CheckpointBook {
+    uint32_t instrument_id;
+    uint16_t publisher_id;
+    uint16_t symbol_length;
+    uint64_t order_count;
+};
+
+struct CheckpointOrder {
+    int64_t order_id;
+    int64_t price;
+    int32_t size;
+    char side;
+    uint8_t reserved[3];
+};
+
+static_assert(sizeof(CheckpointHeader) == 64, "checkpoint header must be 64 bytes");
+static_assert(sizeof(CheckpointOutput) == 24, "checkpoint output must be 24 bytes");
+static_assert(sizeof(CheckpointBook) == 16, "checkpoint book must be 16 bytes");
+static_assert(sizeof(CheckpointOrder) == 24, "checkpoint order must be 24 bytes");
+
+// Where a replay stood when the checkpoint was taken
+struct CheckpointPosition {
+    uint64_t records = 0;
+    uint64_t input_offset = NO_INPUT_OFFSET;
+    int64_t ts_recv = 0;
+    uint32_t sequence = 0;
+    bool changes_only = false;
+    std::vector<CheckpointOutput> outputs;  // one per MBP output file
+};
+
+// Write books and position to filename. The file is written next to it and
+// renamed into place, so a crash never leaves a torn checkpoint behind.
+bool writeCheckpoint(const std::string& filename, const BookManager& books, const CheckpointPosition& position);
+
+// Replace the contents of books (whose view depth is kept) with a checkpoint
+bool readCheckpoint(const std::string& filename, BookManager& books, CheckpointPosition& position);
+
+// Same, at the current position of a binary stream (e.g. inside a replay index)
+bool writeCheckpoint(std::ostream& out, const BookManager& books, const CheckpointPosition& position);
+bool readCheckpoint(std::istream& in, BookManager& books, CheckpointPosition& position);
+
+#endif // CHECKPOINT_H
@@ -1,73 +1,361 @@
 #include "orderbook.h"
+#include "mbo_reader.h"
+#include "symbol_table.h"
+#include "timestamp.h"
 #include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+#include <thread>
 
 // CSVParser Implementation
-std::vector<MBORecord> CSVParser::parseFile(const std::string& filename) {
+namespace {
+
+constexpr size_t MBO_FIELD_COUNT = 15;
+
+template <typename T>
+inline bool parseNumber(std::string_view field, T& value) {
+    const char* first = field.data();
+    const char* last = first + field.size();
+    auto result = std::from_chars(first, last, value);
+    return result.ec == std::errc() && result.ptr == last;
+}
+
+// Parse a decimal price straight into 1e-9 fixed-point units. Digits beyond
+// the ninth fractional place are truncated.
+inline bool parsePrice(std::string_view field, int64_t& price) {
+    const char* p = field.data();
+    const char* last = p + field.size();
+    bool negative = false;
+    if (p != last && (*p == '-' || *p == '+')) {
+        negative = (*p == '-');
+        ++p;
+    }
+
+    uint64_t whole = 0;
+    const char* digits_start = p;
+    while (p != last && static_cast<unsigned>(*p - '0') < 10) {
+        whole = whole * 10 + static_cast<unsigned>(*p - '0');
+        ++p;
+    }
+    bool has_digits = p != digits_start;
+    if (p - digits_start > 9) {
+        return false; // Prices of 1e9 or more are out of range
+    }
+
+    uint64_t fraction = 0;
+    int fraction_digits = 0;
+    if (p != last && *p == '.') {
+        ++p;
+        const char* fraction_start = p;
+        while (p != last && static_cast<unsigned>(*p - '0') < 10) {
+            if (fraction_digits < 9) {
+                fraction = fraction * 10 + static_cast<unsigned>(*p - '0');
+                fraction_digits++;
+            }
+            ++p;
+        }
+        has_digits = has_digits || p != fraction_start;
+    }
+    if (!has_digits || p != last) {
+        return false;
+    }
+
+    static constexpr uint64_t POW10[] = {1000000000, 100000000, 10000000, 1000000, 100000,
+                                         10000, 1000, 100, 10, 1};
+    int64_t value = static_cast<int64_t>(whole * PRICE_SCALE + fraction * POW10[fraction_digits]);
+    price = negative ? -value : value;
+    return true;
+}
+
+// Files rarely change symbol from line to line: remember the last one per thread
+inline uint32_t internSymbol(std::string_view symbol) {
+    thread_local std::string last_symbol;
+    thread_local uint32_t last_id = 0;
+    thread_local bool cached = false;
+    if (!cached || symbol != last_symbol) {
+        last_id = SymbolTable::global().intern(symbol);
+        last_symbol.assign(symbol.data(), symbol.size());
+        cached = true;
+    }
+    return last_id;
+}
+
+// Split line into the first MBO_FIELD_COUNT comma-separated fields without copying
+inline bool tokenize(std::string_view line, std::string_view* fields) {
+    size_t pos = 0;
+    for (size_t i = 0; i < MBO_FIELD_COUNT; ++i) {
+        size_t comma = line.find(',', pos);
+        if (comma == std::string_view::npos) {
+            if (i != MBO_FIELD_COUNT - 1) return false;
+            fields[i] = line.substr(pos);
+        } else {
+            fields[i] = line.substr(pos, comma - pos);
+        }
+        pos = comma + 1;
+    }
+    return true;
+}
+
+// Smallest byte range worth handing to a parser thread
+constexpr size_t MIN_CHUNK_BYTES = 1 << 16;
+
+struct ParsedChunk {
+    const char* begin = nullptr;
+    const char* end = nullptr;
     std::vector<MBORecord> records;
-    std::ifstream file(filename);
+    std::vector<uint64_t> positions;  // chunk-relative offset past each record, if wanted
+    ParseStats stats;   // line numbers relative to the chunk
+    size_t lines = 0;   // file lines in the chunk, blank ones included
+};
+
+// Parse the whole lines of a chunk with the same rules as MBOReader::next
+void parseChunk(ParsedChunk& chunk, bool want_positions) {
+    MBORecord record;
+    const char* cursor = chunk.begin;
+    while (cursor < chunk.end) {
+        const char* newline = static_cast<const char*>(std::memchr(cursor, '\n', chunk.end - cursor));
+        const char* line_end = newline ? newline : chunk.end;
+        std::string_view line(cursor, line_end - cursor);
+        cursor = newline ? newline + 1 : chunk.end;
+        chunk.lines++;
+
+        if (line.empty() || line == "\r") {
+            continue;
+        }
+
+        chunk.stats.lines++;
+        ParseError error = CSVParser::parseLine(line, record);
+        if (error != ParseError::None) {
+            chunk.stats.recordError(error, chunk.lines);
+            continue;
+        }
+        chunk.stats.records++;
+        chunk.records.push_back(record);
+        if (want_positions) {
+            chunk.positions.push_back(static_cast<uint64_t>(cursor - chunk.begin));
+        }
+    }
+}
+
+// Split body into up to count ranges, each starting just after a newline
+std::vector<ParsedChunk> splitChunks(const char* body, const char* end, size_t count) {
+    std::vector<ParsedChunk> chunks(count);
+    size_t step = (end - body) / count;
+    const char* start = body;
+    for (size_t i = 0; i < count; ++i) {
+        chunks[i].begin = start;
+        if (i + 1 < count) {
+            const char* target = std::max(start, body + (i + 1) * step);
+            const char* newline = target == end ? nullptr
+                : static_cast<const char*>(std::memchr(target, '\n', end - target));
+            start = newline ? newline + 1 : end;
+        } else {
+            start = end;
+        }
+        chunks[i].end = start;
+    }
+    return chunks;
+}
+
+// Parse body, the file from its first record or from a record boundary, in
+// parallel; line numbers count from the first line of body
+std::vector<MBORecord> parseMappedParallel(const MappedFile& file, const char* body, size_t line_offset, int threads,
+                                           ParseStats& stats, std::vector<uint64_t>* positions) {
+    const char* data = file.data();
+    const char* end = data + file.size();
 
-    if (!file.is_open()) {
-        std::cerr << "Error: Cannot open file " << filename << std::endl;
-        return records;
+    size_t count = std::min(static_cast<size_t>(threads) * 4,
+                            std::max<size_t>(1, static_cast<size_t>(end - body) / MIN_CHUNK_BYTES));
+    std::vector<ParsedChunk> chunks = splitChunks(body, end, count);
+
+    std::atomic<size_t> next_chunk{0};
+    auto worker = [&] {
+        for (size_t i = next_chunk++; i < chunks.size(); i = next_chunk++) {
+            parseChunk(chunks[i], positions != nullptr);
+        }
+    };
+    std::vector<std::thread> pool;
+    for (int i = 1; i < threads && static_cast<size_t>(i) < chunks.size(); ++i) {
+        pool.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : pool) {
+        thread.join();
     }
 
-    std::string line;
-    bool first_line = true;
+    // Concatenate in input order and rebase line numbers
+    size_t total = 0;
+    for (const auto& chunk : chunks) {
+        total += chunk.records.size();
+    }
+    std::vector<MBORecord> records;
+    records.reserve(total);
+    if (positions) {
+        positions->reserve(total);
+    }
 
-    while (std::getline(file, line)) {
-        if (first_line) {
-            first_line = false;
-            continue; // Skip header
+    for (auto& chunk : chunks) {
+        stats.lines += chunk.stats.lines;
+        stats.records += chunk.stats.records;
+        stats.errors += chunk.stats.errors;
+        for (size_t e = 0; e < static_cast<size_t>(ParseError::Count); ++e) {
+            stats.by_error[e] += chunk.stats.by_error[e];
+        }
+        if (stats.first_error == ParseError::None && chunk.stats.first_error != ParseError::None) {
+            stats.first_error = chunk.stats.first_error;
+            stats.first_error_line = line_offset + chunk.stats.first_error_line;
         }
+        line_offset += chunk.lines;
 
-        if (!line.empty()) {
-            try {
-                MBORecord record = parseLine(line);
-                records.push_back(record);
-            } catch (const std::exception& e) {
-                std::cerr << "Error parsing line: " << line << std::endl;
-                std::cerr << "Exception: " << e.what() << std::endl;
+        std::move(chunk.records.begin(), chunk.records.end(), std::back_inserter(records));
+        std::vector<MBORecord>().swap(chunk.records);
+        if (positions) {
+            uint64_t base = static_cast<uint64_t>(chunk.begin - data);
+            for (uint64_t position : chunk.positions) {
+                positions->push_back(base + position);
             }
+            std::vector<uint64_t>().swap(chunk.positions);
         }
     }
+    return records;
+}
+
+} // namespace
+
+const char* parseErrorName(ParseError error) {
+    switch (error) {
+        case ParseError::None: return "none";
+        case ParseError::MissingFields: return "missing fields";
+        case ParseError::BadInteger: return "bad integer";
+        case ParseError::BadPrice: return "bad price";
+        case ParseError::LineTooLong: return "line too long";
+        case ParseError::BadTimestamp: return "bad timestamp";
+        case ParseError::BadSymbol: return "bad symbol id";
+        default: return "unknown";
+    }
+}
 
-    file.close();
+std::vector<MBORecord> CSVParser::parseFile(const std::string& filename, int threads, ParseStats* stats_out) {
+    std::vector<MBORecord> records;
+    parseFileFrom(filename, 0, records, nullptr, threads, stats_out);
     return records;
 }
 
-MBORecord CSVParser::parseLine(const std::string& line) {
-    std::vector<std::string> fields = splitCSV(line);
+bool CSVParser::parseFileFrom(const std::string& filename, uint64_t start, std::vector<MBORecord>& records,
+                              std::vector<uint64_t>* positions, int threads, ParseStats* stats_out) {
+    records.clear();
+    if (positions) {
+        positions->clear();
+    }
+    ParseStats stats;
 
-    if (fields.size() < 15) {
-        throw std::runtime_error("Insufficient fields in CSV line");
+    MappedFile file;
+    bool is_binary = false;
+    if (threads > 1 && file.open(filename)) {
+        is_binary = file.size() >= sizeof(BINARY_MBO_MAGIC) &&
+                    std::memcmp(file.data(), BINARY_MBO_MAGIC, sizeof(BINARY_MBO_MAGIC)) == 0;
     }
 
-    MBORecord record;
+    if (file.isOpen() && !is_binary) {
+        // Line 1 is the header; a later start must follow a newline
+        const char* data = file.data();
+        const char* body = file.size() == 0 ? data : static_cast<const char*>(std::memchr(data, '\n', file.size()));
+        body = body ? body + 1 : data + file.size();
+        if (start != 0) {
+            if (start < static_cast<uint64_t>(body - data) || start > file.size() || data[start - 1] != '\n') {
+                std::cerr << "Error: Cannot seek " << filename << " to byte " << start << std::endl;
+                return false;
+            }
+            body = data + start;
+        }
+        records = parseMappedParallel(file, body, start == 0 ? 1 : 0, threads, stats, positions);
+    } else {
+        // Serial path, also used for binary input (which needs no parsing)
+        MBOReader reader;
+        if (!reader.open(filename)) {
+            std::cerr << "Error: Cannot open file " << filename << std::endl;
+            return false;
+        }
+        if (start != 0 && !reader.seek(start)) {
+            std::cerr << "Error: Cannot seek " << filename << " to byte " << start << std::endl;
+            return false;
+        }
+
+        MBORecord record;
+        while (reader.next(record)) {
+            records.push_back(record);
+            if (positions) {
+                positions->push_back(reader.position());
+            }
+        }
+        stats = reader.stats();
+    }
 
-    try {
-        record.ts_recv = fields[0];
-        record.ts_event = fields[1];
-        record.rtype = std::stoi(fields[2]);
-        record.publisher_id = std::stoi(fields[3]);
-        record.instrument_id = std::stoi(fields[4]);
-        record.action = fields[5].empty() ? '?' : fields[5][0];
-        record.side = fields[6].empty() ? '?' : fields[6][0];
-        record.price = fields[7].empty() ? 0.0 : std::stod(fields[7]);
-        record.size = fields[8].empty() ? 0 : std::stoi(fields[8]);
-        record.channel_id = std::stoi(fields[9]);
-        record.order_id = std::stol(fields[10]);
-        record.flags = std::stoi(fields[11]);
-        record.ts_in_delta = std::stoi(fields[12]);
-        record.sequence = std::stol(fields[13]);
-        record.symbol = fields[14];
-    } catch (const std::exception& e) {
-        std::cerr << "Error parsing fields: " << e.what() << std::endl;
-        throw;
+    if (stats_out) {
+        *stats_out = stats;
     }
+    if (stats.errors > 0) {
+        std::cerr << "Skipped " << stats.errors << " malformed line(s) in " << filename
+                  << " (first at line " << stats.first_error_line << ": "
+                  << parseErrorName(stats.first_error) << ")" << std::endl;
+    }
+    return true;
+}
 
+MBORecord CSVParser::parseLine(const std::string& line) {
+    MBORecord record;
+    ParseError error = parseLine(std::string_view(line), record);
+    if (error != ParseError::None) {
+        throw std::runtime_error(std::string("Error parsing CSV line: ") + parseErrorName(error));
+    }
     return record;
 }
 
+ParseError CSVParser::parseLine(std::string_view line, MBORecord& record) {
+    LATENCY_STAGE(Parse);
+    if (!line.empty() && line.back() == '\r') {
+        line.remove_suffix(1);
+    }
+
+    std::string_view fields[MBO_FIELD_COUNT];
+    if (!tokenize(line, fields)) {
+        return ParseError::MissingFields;
+    }
+
+    thread_local TimestampCodec timestamps;
+    if (!timestamps.parse(fields[0], record.ts_recv) || !timestamps.parse(fields[1], record.ts_event)) {
+        return ParseError::BadTimestamp;
+    }
+    record.action = fields[5].empty() ? '?' : fields[5][0];
+    record.side = fields[6].empty() ? '?' : fields[6][0];
+
+    if (fields[7].empty()) {
+        record.price = 0;
+    } else if (!parsePrice(fields[7], record.price)) {
+        return ParseError::BadPrice;
+    }
+
+    record.size = 0;
+    if (!parseNumber(fields[2], record.rtype) ||
+        !parseNumber(fields[3], record.publisher_id) ||
+        !parseNumber(fields[4], record.instrument_id) ||
+        (!fields[8].empty() && !parseNumber(fields[8], record.size)) ||
+        !parseNumber(fields[9], record.channel_id) ||
+        !parseNumber(fields[10], record.order_id) ||
+        !parseNumber(fields[11], record.flags) ||
+        !parseNumber(fields[12], record.ts_in_delta) ||
+        !parseNumber(fields[13], record.sequence)) {
+        return ParseError::BadInteger;
+    }
+
+    // Interned last so that rejected lines never grow the symbol table
+    record.symbol_id = internSymbol(fields[14]);
+    return ParseError::None;
+}
+
 std::vector<std::string> CSVParser::splitCSV(const std::string& line) {
     std::vector<std::string> fields;
     std::stringstream ss(line);
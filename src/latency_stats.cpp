@@ -0,0 +1,243 @@
+#include "latency_stats.h"
+#include <csignal>
+#include <cstdlib>
+#include <fstream>
+#include <mutex>
+#include <new>
+#include <pthread.h>
+#include <thread>
+#include <vector>
+
+namespace latency {
+
+namespace {
+
+std::atomic<uint64_t> allocation_count{0};
+
+std::mutex registry_mutex;
+std::vector<LatencyRecorder*>& registry() {
+    // Never destroyed: recorders outlive their threads, and the exit report
+    // may run after static destructors
+    static auto* recorders = new std::vector<LatencyRecorder*>();
+    return *recorders;
+}
+
+// TSC and steady clock read together at startup, for ticks-per-ns calibration
+struct ClockOrigin {
+    uint64_t ticks = now();
+    std::chrono::steady_clock::time_point time = std::chrono::steady_clock::now();
+};
+const ClockOrigin origin;
+
+double ticksPerNs() {
+#if defined(__x86_64__) || defined(__i386__)
+    auto elapsed = [] { return std::chrono::steady_clock::now() - origin.time; };
+    if (elapsed() < std::chrono::milliseconds(20)) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20) - elapsed());
+    }
+    uint64_t ticks = now() - origin.ticks;
+    double ns = std::chrono::duration<double, std::nano>(elapsed()).count();
+    return ns > 0 ? ticks / ns : 1.0;
+#else
+    return 1.0;
+#endif
+}
+
+void writeHistogram(std::ostream& out, const char* name, const LatencyHistogram& histogram, double ticks_per_ns) {
+    auto ns = [ticks_per_ns](double ticks) { return ticks / ticks_per_ns; };
+    out << "    \"" << name << "\": {\"events\": " << histogram.eventCount() << ", \"samples\": " << histogram.count()
+        << ", \"mean_ns\": " << ns(histogram.mean())
+        << ", \"p50_ns\": " << ns(histogram.percentile(0.50)) << ", \"p90_ns\": " << ns(histogram.percentile(0.90))
+        << ", \"p99_ns\": " << ns(histogram.percentile(0.99)) << ", \"p999_ns\": " << ns(histogram.percentile(0.999))
+        << ", \"max_ns\": " << ns(histogram.max()) << "}";
+}
+
+std::string report_file;
+std::mutex write_mutex;
+
+void writeAtExit() {
+    writeLatencyJson(report_file);
+}
+
+void signalLoop(sigset_t signals) {
+    for (;;) {
+        int signal = 0;
+        if (sigwait(&signals, &signal) != 0) {
+            continue;
+        }
+        writeLatencyJson(report_file);
+        if (signal != SIGUSR1) {
+            std::_Exit(128 + signal);
+        }
+    }
+}
+
+} // namespace
+
+const char* stageName(Stage stage) {
+    switch (stage) {
+        case Stage::Parse: return "parse";
+        case Stage::Apply: return "apply";
+        case Stage::Snapshot: return "snapshot";
+        case Stage::Format: return "format";
+        case Stage::Write: return "write";
+        default: return "unknown";
+    }
+}
+
+const char* actionName(Action action) {
+    switch (action) {
+        case Action::Add: return "add";
+        case Action::Modify: return "modify";
+        case Action::Cancel: return "cancel";
+        case Action::Trade: return "trade";
+        case Action::Fill: return "fill";
+        case Action::TradeCancel: return "trade_cancel";
+        case Action::Reset: return "reset";
+        default: return "other";
+    }
+}
+
+// LatencyHistogram Implementation
+void LatencyHistogram::merge(const LatencyHistogram& other) {
+    for (int i = 0; i < BUCKETS; ++i) {
+        bump(counts[i], other.counts[i].load(std::memory_order_relaxed));
+    }
+    bump(events, other.eventCount());
+    bump(total, other.count());
+    bump(sum, other.sum.load(std::memory_order_relaxed));
+    if (other.max() > max()) {
+        maximum.store(other.max(), std::memory_order_relaxed);
+    }
+}
+
+void LatencyHistogram::reset() {
+    for (auto& bucket : counts) bucket.store(0, std::memory_order_relaxed);
+    events.store(0, std::memory_order_relaxed);
+    total.store(0, std::memory_order_relaxed);
+    countdown = 0;
+    sum.store(0, std::memory_order_relaxed);
+    maximum.store(0, std::memory_order_relaxed);
+}
+
+double LatencyHistogram::mean() const {
+    uint64_t n = count();
+    return n ? static_cast<double>(sum.load(std::memory_order_relaxed)) / n : 0.0;
+}
+
+uint64_t LatencyHistogram::percentile(double q) const {
+    uint64_t n = count();
+    if (n == 0) return 0;
+    uint64_t rank = std::min<uint64_t>(n - 1, static_cast<uint64_t>(q * n));
+    uint64_t seen = 0;
+    for (int i = 0; i < BUCKETS; ++i) {
+        seen += counts[i].load(std::memory_order_relaxed);
+        if (seen > rank) {
+            uint64_t low = bucketLow(i);
+            uint64_t high = i + 1 < BUCKETS ? bucketLow(i + 1) - 1 : low;
+            return std::min(low + (high - low) / 2, max());
+        }
+    }
+    return max();
+}
+
+LatencyRecorder& registerThread() {
+    LatencyRecorder* r = new LatencyRecorder();
+    {
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        registry().push_back(r);
+    }
+    thread_recorder = r;
+    return *r;
+}
+
+uint64_t allocations() {
+    return allocation_count.load(std::memory_order_relaxed);
+}
+
+bool writeLatencyJson(const std::string& filename) {
+    std::lock_guard<std::mutex> write_lock(write_mutex);
+
+    LatencyRecorder merged;
+    size_t threads;
+    {
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        threads = registry().size();
+        for (const LatencyRecorder* r : registry()) {
+            for (int i = 0; i < static_cast<int>(Stage::Count); ++i) merged.stages[i].merge(r->stages[i]);
+            for (int i = 0; i < static_cast<int>(Action::Count); ++i) merged.actions[i].merge(r->actions[i]);
+            for (int i = 0; i < static_cast<int>(Counter::Count); ++i) {
+                bump(merged.counters[i], r->counters[i].load(std::memory_order_relaxed));
+            }
+        }
+    }
+    auto counter = [&merged](Counter c) { return merged.counters[static_cast<int>(c)].load(std::memory_order_relaxed); };
+
+    std::ofstream out(filename);
+    if (!out.is_open()) {
+        return false;
+    }
+    double ticks_per_ns = ticksPerNs();
+#ifdef MBO_INSTRUMENT
+    bool enabled = true;
+#else
+    bool enabled = false;
+#endif
+    out << "{\n  \"instrumented\": " << (enabled ? "true" : "false") << ",\n  \"threads\": " << threads
+        << ",\n  \"ticks_per_ns\": " << ticks_per_ns << ",\n  \"sample_every\": " << SAMPLE_EVERY
+        << ",\n  \"stages\": {\n";
+    for (int i = 0; i < static_cast<int>(Stage::Count); ++i) {
+        writeHistogram(out, stageName(static_cast<Stage>(i)), merged.stages[i], ticks_per_ns);
+        out << (i + 1 < static_cast<int>(Stage::Count) ? ",\n" : "\n");
+    }
+    out << "  },\n  \"actions\": {\n";
+    for (int i = 0; i < static_cast<int>(Action::Count); ++i) {
+        writeHistogram(out, actionName(static_cast<Action>(i)), merged.actions[i], ticks_per_ns);
+        out << (i + 1 < static_cast<int>(Action::Count) ? ",\n" : "\n");
+    }
+    out << "  },\n  \"counters\": {\n"
+        << "    \"orders_live\": " << counter(Counter::OrdersAdded) - counter(Counter::OrdersRemoved) << ",\n"
+        << "    \"levels_live\": " << counter(Counter::LevelsAdded) - counter(Counter::LevelsRemoved) << ",\n"
+        << "    \"orders_added\": " << counter(Counter::OrdersAdded) << ",\n"
+        << "    \"levels_added\": " << counter(Counter::LevelsAdded) << ",\n"
+        << "    \"hash_probes\": " << counter(Counter::HashProbes) << ",\n"
+        << "    \"allocations\": " << allocations() << "\n"
+        << "  }\n}\n";
+    return static_cast<bool>(out);
+}
+
+void installLatencyReporting(const std::string& filename) {
+    report_file = filename;
+    std::atexit(writeAtExit);
+
+    // Blocked here and in every thread started later; only signalLoop takes them
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGUSR1);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+    std::thread(signalLoop, signals).detach();
+}
+
+} // namespace latency
+
+#ifdef MBO_INSTRUMENT
+// Count every heap allocation of the process
+void* operator new(size_t size) {
+    latency::allocation_count.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size) {
+    latency::allocation_count.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t) noexcept { std::free(p); }
+#endif
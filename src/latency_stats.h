@@ -0,0 +1,246 @@
+#ifndef LATENCY_STATS_H
+#define LATENCY_STATS_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// Per-stage and per-action latency histograms and event counters.
+//
+// Compiled in with -DMBO_INSTRUMENT (make instrument). Without it every
+// LATENCY_* macro expands to nothing and the hot paths are unchanged. With
+// it, each thread records into its own LatencyRecorder: timestamps are raw
+// TSC reads, histograms are log-linear (8 sub-buckets per power of two, so
+// percentiles are within 12.5%), and counters are plain per-thread adds.
+// writeLatencyJson merges all threads' recorders.
+//
+// A TSC read costs as much as 20 ns under virtualization, so not every
+// event is timed: each histogram times its first SAMPLE_ALL events and then
+// one in SAMPLE_EVERY (events are still all counted). Sampling is blind to
+// the latency itself, so percentiles are unbiased.
+#ifndef LATENCY_SAMPLE_EVERY
+#define LATENCY_SAMPLE_EVERY 16
+#endif
+
+namespace latency {
+
+constexpr uint64_t SAMPLE_ALL = 4096;
+constexpr uint32_t SAMPLE_EVERY = LATENCY_SAMPLE_EVERY;
+
+enum class Stage : uint8_t { Parse, Apply, Snapshot, Format, Write, Count };
+enum class Action : uint8_t { Add, Modify, Cancel, Trade, Fill, TradeCancel, Reset, Other, Count };
+enum class Counter : uint8_t { HashProbes, OrdersAdded, OrdersRemoved, LevelsAdded, LevelsRemoved, Count };
+
+const char* stageName(Stage stage);
+const char* actionName(Action action);
+
+inline Action actionOf(char action) {
+    switch (action) {
+        case 'A': return Action::Add;
+        case 'M': return Action::Modify;
+        case 'C': return Action::Cancel;
+        case 'T': return Action::Trade;
+        case 'F': return Action::Fill;
+        case 'R': return Action::Reset;
+        default: return Action::Other;
+    }
+}
+
+// TSC ticks; steady clock nanoseconds where there is no TSC
+inline uint64_t now() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+}
+
+// Single-writer counter; relaxed load + store instead of a locked add, and
+// safe to read from another thread
+inline void bump(std::atomic<uint64_t>& value, uint64_t n = 1) {
+    value.store(value.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
+class LatencyHistogram {
+public:
+    static constexpr int SUB_BITS = 3;
+    static constexpr int LINEAR = 2 << SUB_BITS;  // values below are exact
+    static constexpr int BUCKETS = LINEAR + (64 - SUB_BITS - 1) * (1 << SUB_BITS);
+
+private:
+    std::atomic<uint64_t> events{0};   // all events, timed or not
+    std::atomic<uint64_t> total{0};    // timed events
+    std::atomic<uint64_t> sum{0};
+    std::atomic<uint64_t> maximum{0};
+    uint32_t countdown = 0;            // events until the next sample
+    std::atomic<uint64_t> counts[BUCKETS] = {};
+
+public:
+    static int bucketOf(uint64_t value) {
+        if (value < static_cast<uint64_t>(LINEAR)) return static_cast<int>(value);
+        int exponent = 63 - __builtin_clzll(value);
+        int sub = static_cast<int>(value >> (exponent - SUB_BITS)) & ((1 << SUB_BITS) - 1);
+        return LINEAR + (exponent - SUB_BITS - 1) * (1 << SUB_BITS) + sub;
+    }
+
+    // Smallest value in bucket
+    static uint64_t bucketLow(int bucket) {
+        if (bucket < LINEAR) return static_cast<uint64_t>(bucket);
+        int exponent = (bucket - LINEAR) / (1 << SUB_BITS) + SUB_BITS + 1;
+        uint64_t sub = static_cast<uint64_t>((bucket - LINEAR) % (1 << SUB_BITS));
+        return ((1ULL << SUB_BITS) + sub) << (exponent - SUB_BITS);
+    }
+
+    // Count an event; true if it should be timed
+    bool due() {
+        bump(events);
+        if (warming()) return true;
+        if (countdown > 0) {
+            countdown--;
+            return false;
+        }
+        countdown = SAMPLE_EVERY - 1;
+        return true;
+    }
+
+    void countEvent() { bump(events); }
+    bool warming() const { return count() < SAMPLE_ALL; }
+
+    void record(uint64_t value) {
+        bump(counts[bucketOf(value)]);
+        bump(total);
+        bump(sum, value);
+        if (value > maximum.load(std::memory_order_relaxed)) {
+            maximum.store(value, std::memory_order_relaxed);
+        }
+    }
+
+    void merge(const LatencyHistogram& other);
+    void reset();
+
+    uint64_t count() const { return total.load(std::memory_order_relaxed); }
+    uint64_t eventCount() const { return events.load(std::memory_order_relaxed); }
+    uint64_t max() const { return maximum.load(std::memory_order_relaxed); }
+    double mean() const;
+
+    // Value at quantile q (0..1): midpoint of its bucket, capped at max()
+    uint64_t percentile(double q) const;
+};
+
+// One thread's histograms and counters
+struct LatencyRecorder {
+    LatencyHistogram stages[static_cast<int>(Stage::Count)];
+    LatencyHistogram actions[static_cast<int>(Action::Count)];
+    std::atomic<uint64_t> counters[static_cast<int>(Counter::Count)] = {};
+
+    // State of the record being applied
+    Action action = Action::Other;
+    bool sampling = false;
+    uint64_t snapshot_ticks = 0;
+
+    LatencyHistogram& stage(Stage s) { return stages[static_cast<int>(s)]; }
+    LatencyHistogram& of(Action a) { return actions[static_cast<int>(a)]; }
+    void count(Counter c, uint64_t n = 1) { bump(counters[static_cast<int>(c)], n); }
+};
+
+// This thread's recorder, created and registered on first use
+LatencyRecorder& registerThread();
+inline thread_local LatencyRecorder* thread_recorder = nullptr;
+inline LatencyRecorder& recorder() {
+    LatencyRecorder* r = thread_recorder;
+    return r ? *r : registerThread();
+}
+
+// Heap allocations so far (counted only in instrumented builds)
+uint64_t allocations();
+
+// Merge every thread's recorder and write the summary as JSON
+bool writeLatencyJson(const std::string& filename);
+
+// Write the summary to filename at exit and on SIGUSR1 (the run continues),
+// SIGINT or SIGTERM (the run then exits). Call before starting other threads.
+void installLatencyReporting(const std::string& filename);
+
+// Times one stage from construction to destruction, when due
+class StageTimer {
+private:
+    LatencyHistogram& histogram;
+    uint64_t start;
+
+public:
+    explicit StageTimer(Stage s) : histogram(recorder().stage(s)) { start = histogram.due() ? now() : 0; }
+    ~StageTimer() {
+        if (start) histogram.record(now() - start);
+    }
+};
+
+// Times one book record, split into its action's total, the view refresh
+// (Snapshot) and the rest (Apply). A record is timed when Apply is due or
+// its action is still warming up; a cancel may turn out to complete a trade.
+class ActionTimer {
+private:
+    LatencyRecorder& r;
+    uint64_t start = 0;
+
+public:
+    explicit ActionTimer(char action) : r(recorder()) {
+        r.action = actionOf(action);
+        r.snapshot_ticks = 0;
+        bool due = r.stage(Stage::Apply).due();
+        r.sampling = due || r.of(r.action).warming() ||
+                     (r.action == Action::Cancel && r.of(Action::TradeCancel).warming());
+        if (r.sampling) start = now();
+    }
+
+    ~ActionTimer() {
+        LatencyHistogram& histogram = r.of(r.action);
+        histogram.countEvent();
+        if (!r.sampling) return;
+        uint64_t ticks = now() - start;
+        histogram.record(ticks);
+        if (r.snapshot_ticks) {
+            r.stage(Stage::Snapshot).record(r.snapshot_ticks);
+        }
+        r.stage(Stage::Apply).record(ticks - std::min(ticks, r.snapshot_ticks));
+        r.sampling = false;
+    }
+};
+
+// Adds its lifetime to the current record's snapshot time
+class SnapshotTimer {
+private:
+    LatencyRecorder& r;
+    uint64_t start = 0;
+
+public:
+    SnapshotTimer() : r(recorder()) {
+        r.stage(Stage::Snapshot).countEvent();
+        if (r.sampling) start = now();
+    }
+    ~SnapshotTimer() {
+        if (start) r.snapshot_ticks += now() - start;
+    }
+};
+
+} // namespace latency
+
+#ifdef MBO_INSTRUMENT
+#define LATENCY_STAGE(stage) latency::StageTimer latency_stage_timer_(latency::Stage::stage)
+#define LATENCY_RECORD(action) latency::ActionTimer latency_action_timer_(action)
+#define LATENCY_RETAG(kind) (latency::recorder().action = latency::Action::kind)
+#define LATENCY_SNAPSHOT() latency::SnapshotTimer latency_snapshot_timer_
+#define LATENCY_COUNT(counter, n) latency::recorder().count(latency::Counter::counter, n)
+#else
+#define LATENCY_STAGE(stage) ((void)0)
+#define LATENCY_RECORD(action) ((void)0)
+#define LATENCY_RETAG(kind) ((void)0)
+#define LATENCY_SNAPSHOT() ((void)0)
+#define LATENCY_COUNT(counter, n) ((void)0)
+#endif
+
+#endif // LATENCY_STATS_H
@@ -0,0 +1,241 @@
+#include "live_ingest.h"
+#include <cerrno>
+#include <cstring>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+// How often a reader blocked on an idle feed checks for close()
+constexpr int STOP_CHECK_MS = 100;
+
+bool socketAddress(const std::string& path, sockaddr_un& address) {
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (path.empty() || path.size() >= sizeof(address.sun_path)) {
+        return false;
+    }
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+    return true;
+}
+
+// Wait up to STOP_CHECK_MS for descriptor to become readable; false once close() was called
+bool waitReadable(int descriptor, const std::atomic<bool>& stopping) {
+    pollfd request{descriptor, POLLIN, 0};
+    while (!stopping.load(std::memory_order_relaxed)) {
+        int ready = ::poll(&request, 1, STOP_CHECK_MS);
+        if (ready > 0) {
+            return true;
+        }
+        if (ready < 0 && errno != EINTR) {
+            return true;  // let read() report the error
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+int connectLiveSocket(const std::string& path) {
+    sockaddr_un address;
+    if (!socketAddress(path, address)) {
+        return -1;
+    }
+    int descriptor = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (descriptor < 0) {
+        return -1;
+    }
+    if (::connect(descriptor, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+        ::close(descriptor);
+        return -1;
+    }
+    return descriptor;
+}
+
+// LiveIngest Implementation
+LiveIngest::~LiveIngest() {
+    close();
+}
+
+bool LiveIngest::openDescriptor(int descriptor) {
+    close();
+    fd = descriptor;
+    return fd >= 0;
+}
+
+bool LiveIngest::listenSocket(const std::string& path) {
+    close();
+    sockaddr_un address;
+    if (!socketAddress(path, address)) {
+        return false;
+    }
+    listen_fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listen_fd < 0) {
+        return false;
+    }
+    ::unlink(path.c_str());  // a stale socket from an earlier run
+    if (::bind(listen_fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 ||
+        ::listen(listen_fd, 1) != 0) {
+        ::close(listen_fd);
+        listen_fd = -1;
+        return false;
+    }
+    socket_path = path;
+    return true;
+}
+
+bool LiveIngest::start(size_t capacity) {
+    if ((fd < 0 && listen_fd < 0) || reader.joinable()) {
+        return false;
+    }
+    if (!book_waiter.open()) {
+        return false;
+    }
+    ring.reset(new SpscQueue<Item>(capacity));
+    finished = false;
+    stopping = false;
+    stalls = 0;
+    parse_stats = ParseStats();
+    reader = std::thread(&LiveIngest::readerLoop, this);
+    return true;
+}
+
+void LiveIngest::push(const Item& item) {
+    if (!ring->tryPush(item)) {
+        stalls.fetch_add(1, std::memory_order_relaxed);
+        unsigned attempts = 0;
+        while (!ring->tryPush(item)) {
+            if (stopping.load(std::memory_order_relaxed)) {
+                return;
+            }
+            backoff(attempts);
+        }
+    }
+    book_waiter.wake();
+}
+
+void LiveIngest::readerLoop() {
+    if (listen_fd >= 0) {
+        while (fd < 0 && waitReadable(listen_fd, stopping)) {
+            fd = ::accept(listen_fd, nullptr, nullptr);
+            if (fd < 0 && errno != EINTR) {
+                break;
+            }
+        }
+    }
+
+    std::unique_ptr<char[]> buffer(new char[READ_BUFFER_SIZE]);
+    size_t kept = 0;          // partial line carried to the next read
+    bool discarding = false;  // inside a line longer than the buffer
+    size_t line_number = 0;
+    Item item;
+
+    while (fd >= 0 && waitReadable(fd, stopping)) {
+        ssize_t n = ::read(fd, buffer.get() + kept, READ_BUFFER_SIZE - kept);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        bool eof = n <= 0;
+        item.received_ns = nowNs();
+
+        const char* p = buffer.get();
+        const char* end = p + kept + (n > 0 ? n : 0);
+        if (discarding) {
+            const char* newline = static_cast<const char*>(std::memchr(p, '\n', end - p));
+            p = newline ? newline + 1 : end;
+            discarding = !newline;
+        }
+
+        // Complete lines, and at EOF a last line without its newline
+        while (p < end) {
+            const char* newline = static_cast<const char*>(std::memchr(p, '\n', end - p));
+            if (!newline && !eof) {
+                break;
+            }
+            std::string_view line(p, (newline ? newline : end) - p);
+            p = newline ? newline + 1 : end;
+            line_number++;
+
+            if (line.empty() || line == "\r" || (line_number == 1 && line.substr(0, 7) == "ts_recv")) {
+                continue;
+            }
+            parse_stats.lines++;
+            ParseError error = CSVParser::parseLine(line, item.record);
+            if (error != ParseError::None) {
+                parse_stats.recordError(error, line_number);
+                continue;
+            }
+            parse_stats.records++;
+            push(item);
+        }
+        if (eof) {
+            break;
+        }
+
+        kept = static_cast<size_t>(end - p);
+        if (kept == READ_BUFFER_SIZE) {
+            // Line longer than the buffer: drop it up to the next newline
+            line_number++;
+            parse_stats.lines++;
+            parse_stats.recordError(ParseError::LineTooLong, line_number);
+            kept = 0;
+            discarding = true;
+        }
+        std::memmove(buffer.get(), p, kept);
+    }
+    finished.store(true, std::memory_order_release);
+    book_waiter.wake();
+}
+
+LiveIngest::Poll LiveIngest::poll(Item& item) {
+    if (ring && ring->tryPop(item)) {
+        return Poll::Record;
+    }
+    if (!finished.load(std::memory_order_acquire)) {
+        return Poll::Empty;
+    }
+    // Everything pushed before finished was set is visible now
+    return ring && ring->tryPop(item) ? Poll::Record : Poll::End;
+}
+
+LiveIngest::Poll LiveIngest::wait(Item& item) {
+    unsigned attempts = 0;
+    for (;;) {
+        Poll state = poll(item);
+        if (state != Poll::Empty) {
+            return state;
+        }
+        if (attempts < SPIN_ATTEMPTS) {
+            spinWait(attempts);
+            continue;
+        }
+
+        book_waiter.park([&]() { return (state = poll(item)) != Poll::Empty; }, STOP_CHECK_MS);
+        if (state != Poll::Empty) {
+            return state;
+        }
+        attempts = 0;
+    }
+}
+
+void LiveIngest::close() {
+    stopping = true;
+    if (reader.joinable()) {
+        reader.join();
+    }
+    if (fd > 0) {
+        ::close(fd);
+    }
+    if (listen_fd >= 0) {
+        ::close(listen_fd);
+        ::unlink(socket_path.c_str());
+    }
+    book_waiter.close();
+    fd = -1;
+    listen_fd = -1;
+    socket_path.clear();
+    ring.reset();
+    finished = false;
+}
@@ -0,0 +1,95 @@
+#ifndef LIVE_INGEST_H
+#define LIVE_INGEST_H
+
+#include "orderbook.h"
+#include "spsc_queue.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+
+// Live MBO ingest from stdin, a pipe or a local UNIX domain socket.
+//
+// A reader thread reads CSV lines in the layout of data/mbo.csv (header
+// optional) as they arrive, parses them and hands each record to the book
+// thread through a lock-free SPSC ring. Every record carries the steady
+// clock time at which read() returned its bytes, so the book thread can
+// measure wire-to-book latency. When the ring is full the reader waits
+// (backpressure, counted in ringStalls()); the feed then backs up into the
+// kernel buffers rather than being dropped.
+//
+// wait() keeps the book thread hot: it spins on the ring for SPIN_ATTEMPTS
+// steps and only then parks on an eventfd, which the reader signals after a
+// push only while the book thread is parked.
+class LiveIngest {
+public:
+    static constexpr size_t DEFAULT_CAPACITY = 1 << 16;
+    static constexpr size_t READ_BUFFER_SIZE = 1 << 16;
+    static constexpr unsigned SPIN_ATTEMPTS = 4096;
+
+    struct Item {
+        MBORecord record;
+        int64_t received_ns;  // steady clock, see nowNs()
+    };
+
+    enum class Poll {
+        Record,  // item holds the next record
+        Empty,   // nothing yet
+        End      // the feed closed and every record was taken
+    };
+
+private:
+    int fd = -1;
+    int listen_fd = -1;
+    std::string socket_path;
+    std::unique_ptr<SpscQueue<Item>> ring;
+    std::thread reader;
+    std::atomic<bool> finished{false};
+    std::atomic<bool> stopping{false};
+    RingWaiter book_waiter;  // the reader wakes a parked book thread
+    std::atomic<uint64_t> stalls{0};
+    ParseStats parse_stats;  // written by the reader, read after End
+
+    void readerLoop();
+    void push(const Item& item);
+
+public:
+    LiveIngest() = default;
+    ~LiveIngest();
+
+    LiveIngest(const LiveIngest&) = delete;
+    LiveIngest& operator=(const LiveIngest&) = delete;
+
+    // Read from an open descriptor (0 for stdin); closed by close() unless it is stdin
+    bool openDescriptor(int descriptor);
+
+    // Listen on a UNIX socket at path; start() then waits for one feed to connect
+    bool listenSocket(const std::string& path);
+
+    // Start the reader thread
+    bool start(size_t capacity = DEFAULT_CAPACITY);
+
+    // Next record without blocking; book thread only
+    Poll poll(Item& item);
+
+    // Next record, waiting for one (Record or End); book thread only
+    Poll wait(Item& item);
+
+    // Stop the reader (after End, or to abandon the feed) and close everything
+    void close();
+
+    const ParseStats& stats() const { return parse_stats; }
+    uint64_t ringStalls() const { return stalls.load(std::memory_order_relaxed); }
+
+    static int64_t nowNs() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+};
+
+// Connect to a LiveIngest socket at path; -1 on failure
+int connectLiveSocket(const std::string& path);
+
+#endif // LIVE_INGEST_H
@@ -1,83 +1,742 @@
 #include "orderbook.h"
+#include "mbo_reader.h"
+#include "mbp_formatter.h"
+#include "book_manager.h"
+#include "parallel_replay.h"
+#include "mbp_binary.h"
+#include "async_writer.h"
+#include "latency_stats.h"
+#include "checkpoint.h"
+#include "live_ingest.h"
+#include <deque>
 #include <iostream>
 #include <fstream>
+#include <memory>
+#include <sstream>
+#include <cstring>
+#include <cstdlib>
+#include <algorithm>
+#include <sys/resource.h>
+
+static void printUsage(const char* program) {
+    std::cerr << "Usage: " << program << " [--stream] [--threads N] [--parse-threads N] [--format csv|binary|columnar] [--direct-io] [--changes-only] [--depth 1,10,50] [--latency-json FILE] [--checkpoint FILE [--checkpoint-every N] [--restart]] <input_mbo_file.csv | --live -|SOCKET>" << std::endl;
+    std::cerr << "  --stream             Read, apply and write one record at a time with a fixed-size buffer" << std::endl;
+    std::cerr << "  --threads N          Replay instruments on N worker threads (output is identical)" << std::endl;
+    std::cerr << "  --parse-threads N    Parse the CSV on N threads before a batch replay" << std::endl;
+    std::cerr << "  --format F           Output as csv (default), fixed-width binary or columnar binary" << std::endl;
+    std::cerr << "  --direct-io          Write CSV output with O_DIRECT where the filesystem supports it" << std::endl;
+    std::cerr << "  --changes-only       Write a row only when the levels written to a file change" << std::endl;
+    std::cerr << "  --depth D[,D...]     Write MBP-1, MBP-10 (default) and/or MBP-50 CSV files in one pass" << std::endl;
+    std::cerr << "  --latency-json FILE  Latency histograms and counters file (make instrument builds only;" << std::endl;
+    std::cerr << "                       default ../output/latency_stats.json)" << std::endl;
+    std::cerr << "  --checkpoint FILE    Save the books and output positions to FILE during the replay" << std::endl;
+    std::cerr << "  --checkpoint-every N Records between checkpoints (default 1000000)" << std::endl;
+    std::cerr << "  --restart            Resume from the checkpoint in FILE instead of the first record" << std::endl;
+    std::cerr << "  --live -|SOCKET      Apply records from stdin or a UNIX socket as they arrive until the feed closes" << std::endl;
+}
+
+// Comma-separated list of supported depths, in order and without duplicates
+static bool parseDepths(const char* text, std::vector<int>& depths) {
+    depths.clear();
+    std::istringstream input(text);
+    std::string item;
+    while (std::getline(input, item, ',')) {
+        int depth = std::atoi(item.c_str());
+        if (depth != 1 && depth != BOOK_DEPTH && depth != MAX_BOOK_DEPTH) {
+            return false;
+        }
+        if (std::find(depths.begin(), depths.end(), depth) == depths.end()) {
+            depths.push_back(depth);
+        }
+    }
+    return !depths.empty();
+}
+
+// One MBP output file with its own row numbering
+class DepthOutput {
+public:
+    virtual ~DepthOutput() = default;
+
+    // Write the record's row if it produces one at this output's depth
+    virtual void write(BookEntry& entry, const MBORecord& record) = 0;
+    virtual bool close() = 0;
+
+    // Checkpoint support: make every row so far durable and report the file length
+    virtual bool flush() = 0;
+    virtual uint64_t bytes() const = 0;
+
+    int depth() const { return output_depth; }
+    long rows() const { return row_count; }
+    void resumeRows(long rows) { row_count = rows; }
+
+protected:
+    explicit DepthOutput(int depth) : output_depth(depth) {}
+
+    int output_depth;
+    long row_count = 0;
+};
+
+// MBP-Depth CSV text written on a background thread
+template <int Depth>
+class CsvOutput : public DepthOutput {
+private:
+    EmitMode mode;
+    AsyncWriter writer;
+    std::deque<BasicMBPFormatter<Depth>> formatters;  // by BookEntry::index
+
+    // MBP-10 reuses the formatter every book already carries
+    BasicMBPFormatter<Depth>& formatterFor(BookEntry& entry) {
+        if constexpr (Depth == BOOK_DEPTH) {
+            return entry.formatter;
+        } else {
+            if (entry.index >= formatters.size()) {
+                formatters.resize(entry.index + 1);
+            }
+            return formatters[entry.index];
+        }
+    }
+
+public:
+    explicit CsvOutput(EmitMode emit_mode) : DepthOutput(Depth), mode(emit_mode) {}
+
+    // keep_bytes > 0 resumes an existing file (header included) at that length
+    bool open(const std::string& filename, bool direct_io, uint64_t keep_bytes = 0) {
+        AsyncWriter::Options options;
+        options.direct_io = direct_io;
+        options.keep_bytes = keep_bytes;
+        if (!writer.open(filename, options)) return false;
+        if (keep_bytes == 0) {
+            std::ostringstream header;
+            writeMBPHeader(header, Depth);
+            writer.append(header.str());
+        }
+        return true;
+    }
+
+    void write(BookEntry& entry, const MBORecord& record) override {
+        if (emitsRow<Depth>(mode, record, entry.book)) {
+            writer.append(formatterFor(entry).formatRow(record, row_count++, entry.book));
+        }
+    }
+
+    bool flush() override { return writer.flush(); }
+    uint64_t bytes() const override { return writer.stats().bytes; }
+
+    bool close() override {
+        AsyncWriter::Stats stats = writer.stats();
+        bool ok = writer.close();
+        std::cout << "Output writer (MBP-" << Depth << "): " << stats.bytes << " bytes, " << stats.stalls
+                  << " stall(s)" << (stats.direct_io ? ", O_DIRECT" : "") << std::endl;
+        return ok;
+    }
+};
+
+// MBP-10 rows in a binary MBP file
+class BinaryOutput : public DepthOutput {
+private:
+    EmitMode mode;
+    MBPFileWriter file;
+
+public:
+    explicit BinaryOutput(EmitMode emit_mode) : DepthOutput(BOOK_DEPTH), mode(emit_mode) {}
+
+    bool open(const std::string& filename, MBPLayout layout) { return file.open(filename, layout); }
+
+    void write(BookEntry& entry, const MBORecord& record) override {
+        if (emitsRow(mode, record, entry.book)) {
+            file.write(record, entry.book);
+            row_count++;
+        }
+    }
+
+    // Binary MBP files are not checkpointed
+    bool flush() override { return false; }
+    uint64_t bytes() const override { return 0; }
+
+    bool close() override {
+        file.close();
+        return true;
+    }
+};
+
+// Output file for one depth: MBP-10 keeps the original names
+static std::string outputFileFor(const std::string& format, int depth) {
+    if (format == "binary") return "../output/output_mbp.bin";
+    if (format == "columnar") return "../output/output_mbp.col";
+    if (depth == BOOK_DEPTH) return "../output/output_mbp.csv";
+    return "../output/output_mbp" + std::to_string(depth) + ".csv";
+}
+
+// Every requested depth written in the same pass over the records
+struct RowOutput {
+    std::vector<std::unique_ptr<DepthOutput>> outputs;
+
+    // With resume, CSV files continue at the checkpoint's rows and lengths
+    bool open(const std::string& format, const std::vector<int>& depths, EmitMode mode, bool direct_io,
+              const CheckpointPosition* resume = nullptr) {
+        for (int depth : depths) {
+            std::string filename = outputFileFor(format, depth);
+            const CheckpointOutput* saved = nullptr;
+            if (resume) {
+                for (const CheckpointOutput& output : resume->outputs) {
+                    if (output.depth == static_cast<uint32_t>(depth)) saved = &output;
+                }
+            }
+            uint64_t keep_bytes = saved ? saved->bytes : 0;
+            bool opened = false;
+            if (format != "csv") {
+                auto output = std::make_unique<BinaryOutput>(mode);
+                opened = output->open(filename, format == "columnar" ? MBPLayout::Columnar : MBPLayout::Fixed);
+                outputs.push_back(std::move(output));
+            } else if (depth == 1) {
+                auto output = std::make_unique<CsvOutput<1>>(mode);
+                opened = output->open(filename, direct_io, keep_bytes);
+                outputs.push_back(std::move(output));
+            } else if (depth == BOOK_DEPTH) {
+                auto output = std::make_unique<CsvOutput<BOOK_DEPTH>>(mode);
+                opened = output->open(filename, direct_io, keep_bytes);
+                outputs.push_back(std::move(output));
+            } else {
+                auto output = std::make_unique<CsvOutput<MAX_BOOK_DEPTH>>(mode);
+                opened = output->open(filename, direct_io, keep_bytes);
+                outputs.push_back(std::move(output));
+            }
+            if (!opened) {
+                if (saved) {
+                    std::cerr << "Error: Cannot resume output file " << filename << " at " << keep_bytes << " bytes"
+                              << std::endl;
+                } else {
+                    std::cerr << "Error: Cannot create output file " << filename << std::endl;
+                }
+                return false;
+            }
+            if (saved) {
+                outputs.back()->resumeRows(static_cast<long>(saved->rows));
+            }
+        }
+        return true;
+    }
+
+    // Make every row written so far visible in the files
+    bool flush() {
+        bool ok = true;
+        for (auto& output : outputs) {
+            ok = output->flush() && ok;
+        }
+        return ok;
+    }
+
+    // Flush every file and record its rows and length in position
+    bool savePositions(CheckpointPosition& position) {
+        position.outputs.clear();
+        for (auto& output : outputs) {
+            if (!output->flush()) return false;
+            CheckpointOutput saved{};
+            saved.depth = static_cast<uint32_t>(output->depth());
+            saved.rows = static_cast<uint64_t>(output->rows());
+            saved.bytes = output->bytes();
+            position.outputs.push_back(saved);
+        }
+        return true;
+    }
+
+    void write(BookEntry& entry, const MBORecord& record) {
+        for (auto& output : outputs) {
+            output->write(entry, record);
+        }
+    }
+
+    void printRows() const {
+        for (const auto& output : outputs) {
+            std::cout << "Generated " << output->rows() << " MBP-" << output->depth() << " records" << std::endl;
+        }
+    }
+
+    bool close() {
+        bool ok = true;
+        for (auto& output : outputs) {
+            ok = output->close() && ok;
+        }
+        return ok;
+    }
+};
+
+// Periodic checkpoints of a single-threaded replay
+struct Checkpointer {
+    std::string file;     // empty: no checkpoints
+    uint64_t every = 1000000;
+    bool changes_only = false;
+
+    bool due(uint64_t records) const { return !file.empty() && every > 0 && records % every == 0; }
+
+    // Flush the outputs and save every book after records input records; a
+    // failed checkpoint is reported and the replay goes on
+    void save(const BookManager& books, RowOutput& output, const MBORecord& last, uint64_t records,
+              uint64_t input_offset) const {
+        CheckpointPosition position;
+        position.records = records;
+        position.input_offset = input_offset;
+        position.ts_recv = last.ts_recv;
+        position.sequence = last.sequence;
+        position.changes_only = changes_only;
+        if (!output.savePositions(position) || !writeCheckpoint(file, books, position)) {
+            std::cerr << "Warning: Cannot write checkpoint " << file << std::endl;
+        }
+    }
+};
+
+// Print the final state of every book (up to a limit for full-market files)
+static void printBooks(const BookManager& books) {
+    const size_t max_printed = 10;
+    size_t printed = 0;
+    std::cout << "\nBooks: " << books.size() << std::endl;
+    for (const BookEntry& entry : books) {
+        if (printed++ == max_printed) {
+            std::cout << "... " << books.size() - max_printed << " more books not shown" << std::endl;
+            break;
+        }
+        std::cout << "\nFinal orderbook state for " << books.symbols().name(entry.symbol_id)
+                  << " (publisher " << entry.publisher_id << ", instrument " << entry.instrument_id << "):" << std::endl;
+        entry.book.printBook();
+    }
+}
+
+// Parallel mode: instruments sharded over worker threads, rows merged in input order
+static int runParallel(const std::string& input_file, ReadMode mode, int threads, EmitMode emit_mode,
+                       AsyncWriter& output) {
+    MBOReader reader;
+    if (!reader.open(input_file, mode)) {
+        std::cerr << "Error: Cannot open file " << input_file << std::endl;
+        return 1;
+    }
+
+    ParallelReplay replay(threads, ParallelReplay::DEFAULT_BATCH_SIZE, emit_mode);
+    size_t row_count;
+    {
+        PerformanceTimer process_timer("Parallel processing");
+        row_count = replay.run(reader, output);
+    }
+
+    const ParseStats& stats = reader.stats();
+    if (stats.errors > 0) {
+        std::cerr << "Skipped " << stats.errors << " malformed line(s) (first at line "
+                  << stats.first_error_line << ": " << parseErrorName(stats.first_error) << ")" << std::endl;
+    }
+    if (replay.recordsRead() == 0) {
+        std::cerr << "Error: No records found in input file" << std::endl;
+        return 1;
+    }
+
+    std::cout << "Processing complete!" << std::endl;
+    std::cout << "Processed " << replay.recordsRead() << " MBO records on " << threads << " threads" << std::endl;
+    std::cout << "Generated " << row_count << " MBP records" << std::endl;
+    for (size_t i = 0; i < replay.shardCount(); ++i) {
+        std::cout << "\nShard " << i << ":";
+        printBooks(replay.shard(i));
+    }
+    return 0;
+}
+
+static long peakRssKb() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+// Streaming mode: memory stays bounded by the read buffer and the live book
+static int runStreaming(const std::string& input_file, BookManager& books, RowOutput& output,
+                        const Checkpointer& checkpoints, const CheckpointPosition* resume) {
+    MBOReader reader;
+    if (!reader.open(input_file, ReadMode::Streaming)) {
+        std::cerr << "Error: Cannot open file " << input_file << std::endl;
+        return 1;
+    }
+
+    PerformanceTimer process_timer("Streaming processing");
+
+    MBORecord record;
+    long processed_count = 0;
+
+    // Resume at the checkpoint's byte offset, or skip the records it covers
+    if (resume) {
+        if (resume->input_offset != NO_INPUT_OFFSET) {
+            if (!reader.seek(resume->input_offset)) {
+                std::cerr << "Error: Cannot seek " << input_file << " to byte " << resume->input_offset << std::endl;
+                return 1;
+            }
+        } else {
+            for (uint64_t i = 0; i < resume->records; ++i) {
+                if (!reader.next(record)) {
+                    std::cerr << "Error: " << input_file << " ends before the checkpoint" << std::endl;
+                    return 1;
+                }
+            }
+        }
+        processed_count = static_cast<long>(resume->records);
+    }
+
+    while (reader.next(record)) {
+        BookEntry& entry = books.route(record);
+        entry.book.processRecord(record);
+        processed_count++;
+        output.write(entry, record);
+
+        if (checkpoints.due(processed_count)) {
+            checkpoints.save(books, output, record, processed_count, reader.position());
+        }
+
+        // Progress indicator
+        if (processed_count % 1000 == 0) {
+            std::cout << "Processed " << processed_count << " records..." << std::endl;
+        }
+    }
+
+    const ParseStats& stats = reader.stats();
+    if (stats.errors > 0) {
+        std::cerr << "Skipped " << stats.errors << " malformed line(s) (first at line "
+                  << stats.first_error_line << ": " << parseErrorName(stats.first_error) << ")" << std::endl;
+    }
+    if (processed_count == 0) {
+        std::cerr << "Error: No records found in input file" << std::endl;
+        return 1;
+    }
+
+    std::cout << "Processing complete!" << std::endl;
+    std::cout << "Processed " << processed_count << " MBO records" << std::endl;
+    output.printRows();
+    std::cout << "Peak RSS: " << peakRssKb() << " KB" << std::endl;
+    return 0;
+}
+
+// Live mode: records from stdin or a UNIX socket are applied and their rows
+// published as they arrive, until the feed closes
+static int runLive(const std::string& source, BookManager& books, RowOutput& output) {
+    // Under a continuous feed, rows still reach the files this often
+    constexpr int64_t PUBLISH_INTERVAL_NS = 1000000;
+
+    LiveIngest ingest;
+    bool opened = source == "-" ? ingest.openDescriptor(0) : ingest.listenSocket(source);
+    if (!opened || !ingest.start()) {
+        std::cerr << "Error: Cannot read a live feed from " << (source == "-" ? "stdin" : source) << std::endl;
+        return 1;
+    }
+    std::cout << "Waiting for a live feed on " << (source == "-" ? "stdin" : source) << std::endl;
+
+    PerformanceTimer process_timer("Live processing");
+
+    auto wire_to_book = std::make_unique<latency::LatencyHistogram>();
+    LiveIngest::Item item;
+    long processed_count = 0;
+    bool unpublished = false;
+    int64_t published_ns = LiveIngest::nowNs();
+
+    for (;;) {
+        // Block only once every row is published; until then an empty ring means flush
+        LiveIngest::Poll state = unpublished ? ingest.poll(item) : ingest.wait(item);
+        if (state == LiveIngest::Poll::Record) {
+            BookEntry& entry = books.route(item.record);
+            entry.book.processRecord(item.record);
+            int64_t applied_ns = LiveIngest::nowNs();
+            wire_to_book->record(static_cast<uint64_t>(std::max<int64_t>(0, applied_ns - item.received_ns)));
+            processed_count++;
+            output.write(entry, item.record);
+            unpublished = true;
+            if (applied_ns - published_ns < PUBLISH_INTERVAL_NS) {
+                continue;
+            }
+        } else if (state == LiveIngest::Poll::End) {
+            break;
+        }
+
+        // Idle feed or interval elapsed: rows so far become visible to readers of the files
+        output.flush();
+        unpublished = false;
+        published_ns = LiveIngest::nowNs();
+    }
+    ingest.close();
+
+    const ParseStats& stats = ingest.stats();
+    if (stats.errors > 0) {
+        std::cerr << "Skipped " << stats.errors << " malformed line(s) (first at line "
+                  << stats.first_error_line << ": " << parseErrorName(stats.first_error) << ")" << std::endl;
+    }
+    if (processed_count == 0) {
+        std::cerr << "Error: No records received from the live feed" << std::endl;
+        return 1;
+    }
+
+    std::cout << "Processing complete!" << std::endl;
+    std::cout << "Processed " << processed_count << " MBO records" << std::endl;
+    output.printRows();
+    std::cout << "Wire-to-book latency: p50 " << wire_to_book->percentile(0.50) << " ns, p90 "
+              << wire_to_book->percentile(0.90) << " ns, p99 " << wire_to_book->percentile(0.99) << " ns, p99.9 "
+              << wire_to_book->percentile(0.999) << " ns, max " << wire_to_book->max() << " ns" << std::endl;
+    std::cout << "Ring stalls: " << ingest.ringStalls() << std::endl;
+    return 0;
+}
 
 int main(int argc, char* argv[]) {
-    if (argc != 2) {
-        std::cerr << "Usage: " << argv[0] << " <input_mbo_file.csv>" << std::endl;
+    bool streaming = false;
+    int threads = 1;
+    int parse_threads = 1;
+    std::string format = "csv";
+    bool direct_io = false;
+    EmitMode emit_mode = EmitMode::AllRecords;
+    std::vector<int> depths = {BOOK_DEPTH};
+    std::string latency_file;
+    Checkpointer checkpoints;
+    bool restart = false;
+    bool checkpoint_every_set = false;
+    std::string live_source;
+    std::string input_file;
+
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--stream") == 0) {
+            streaming = true;
+        } else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = std::atoi(argv[++i]);
+            if (threads < 1) {
+                printUsage(argv[0]);
+                return 1;
+            }
+        } else if (std::strcmp(argv[i], "--parse-threads") == 0 && i + 1 < argc) {
+            parse_threads = std::atoi(argv[++i]);
+            if (parse_threads < 1) {
+                printUsage(argv[0]);
+                return 1;
+            }
+        } else if (std::strcmp(argv[i], "--format") == 0 && i + 1 < argc) {
+            format = argv[++i];
+            if (format != "csv" && format != "binary" && format != "columnar") {
+                printUsage(argv[0]);
+                return 1;
+            }
+        } else if (std::strcmp(argv[i], "--direct-io") == 0) {
+            direct_io = true;
+        } else if (std::strcmp(argv[i], "--changes-only") == 0) {
+            emit_mode = EmitMode::BookChanges;
+        } else if (std::strcmp(argv[i], "--depth") == 0 && i + 1 < argc) {
+            if (!parseDepths(argv[++i], depths)) {
+                printUsage(argv[0]);
+                return 1;
+            }
+        } else if (std::strcmp(argv[i], "--latency-json") == 0 && i + 1 < argc) {
+            latency_file = argv[++i];
+        } else if (std::strcmp(argv[i], "--checkpoint") == 0 && i + 1 < argc) {
+            checkpoints.file = argv[++i];
+        } else if (std::strcmp(argv[i], "--checkpoint-every") == 0 && i + 1 < argc) {
+            checkpoints.every = std::strtoull(argv[++i], nullptr, 10);
+            checkpoint_every_set = true;
+        } else if (std::strcmp(argv[i], "--restart") == 0) {
+            restart = true;
+        } else if (std::strcmp(argv[i], "--live") == 0 && i + 1 < argc) {
+            live_source = argv[++i];
+        } else if (argv[i][0] == '-' || !input_file.empty()) {
+            printUsage(argv[0]);
+            return 1;
+        } else {
+            input_file = argv[i];
+        }
+    }
+
+    if (input_file.empty() == live_source.empty() || (checkpoints.file.empty() && (restart || checkpoint_every_set))) {
+        printUsage(argv[0]);
         return 1;
     }
+    checkpoints.changes_only = emit_mode == EmitMode::BookChanges;
 
-    std::string input_file = argv[1];
-    std::string output_file = "../output/output_mbp.csv";
+#ifdef MBO_INSTRUMENT
+    // Before any other thread starts, so that only the reporting thread takes the signals
+    if (latency_file.empty()) {
+        latency_file = "../output/latency_stats.json";
+    }
+    latency::installLatencyReporting(latency_file);
+    std::cout << "Latency statistics: " << latency_file << " (at exit, or now with SIGUSR1)" << std::endl;
+#else
+    if (!latency_file.empty()) {
+        std::cerr << "Error: --latency-json needs an instrumented build (make instrument)" << std::endl;
+        return 1;
+    }
+#endif
+
+    bool mbp10_only = depths.size() == 1 && depths[0] == BOOK_DEPTH;
+    if (threads > 1 && (format != "csv" || !mbp10_only)) {
+        std::cerr << "Error: --threads only supports MBP-10 csv output" << std::endl;
+        return 1;
+    }
+    if (format != "csv" && !mbp10_only) {
+        std::cerr << "Error: binary formats only hold MBP-10" << std::endl;
+        return 1;
+    }
+    if (!checkpoints.file.empty() && (threads > 1 || format != "csv")) {
+        std::cerr << "Error: --checkpoint only supports single-threaded csv output" << std::endl;
+        return 1;
+    }
+    if (!live_source.empty() && (threads > 1 || streaming || format != "csv" || !checkpoints.file.empty())) {
+        std::cerr << "Error: --live only supports single-threaded csv output without checkpoints" << std::endl;
+        return 1;
+    }
 
     std::cout << "Starting orderbook reconstruction..." << std::endl;
-    std::cout << "Input file: " << input_file << std::endl;
-    std::cout << "Output file: " << output_file << std::endl;
+    std::cout << "Input file: " << (live_source.empty() ? input_file : "live feed") << std::endl;
+    for (int depth : depths) {
+        std::cout << "Output file: " << outputFileFor(format, depth) << std::endl;
+    }
 
     // Initialize performance timer
     PerformanceTimer total_timer("Total processing");
 
-    // Parse input file
+    // One book per (publisher_id, instrument_id), viewing the deepest requested level
+    BookManager books;
+    books.setViewDepth(*std::max_element(depths.begin(), depths.end()));
+
+    // Books and output positions from the last checkpoint
+    CheckpointPosition resume_position;
+    const CheckpointPosition* resume = nullptr;
+    if (restart) {
+        PerformanceTimer restore_timer("Checkpoint restore");
+        if (!readCheckpoint(checkpoints.file, books, resume_position)) {
+            std::cerr << "Error: Cannot read checkpoint " << checkpoints.file << std::endl;
+            return 1;
+        }
+        bool same_outputs = resume_position.outputs.size() == depths.size();
+        for (const CheckpointOutput& output : resume_position.outputs) {
+            same_outputs = same_outputs &&
+                           std::find(depths.begin(), depths.end(), static_cast<int>(output.depth)) != depths.end();
+        }
+        if (!same_outputs || resume_position.changes_only != checkpoints.changes_only) {
+            std::cerr << "Error: Checkpoint " << checkpoints.file << " was taken with other --depth or --changes-only options"
+                      << std::endl;
+            return 1;
+        }
+        resume = &resume_position;
+        std::cout << "Restarting after record " << resume->records << " (sequence " << resume->sequence << ", "
+                  << books.size() << " book(s))" << std::endl;
+    }
+
+    if (threads > 1) {
+        std::string output_file = outputFileFor(format, BOOK_DEPTH);
+        AsyncWriter output;
+        AsyncWriter::Options options;
+        options.direct_io = direct_io;
+        if (!output.open(output_file, options)) {
+            std::cerr << "Error: Cannot create output file " << output_file << std::endl;
+            return 1;
+        }
+        std::ostringstream header;
+        writeMBPHeader(header);
+        output.append(header.str());
+
+        int status = runParallel(input_file, streaming ? ReadMode::Streaming : ReadMode::Mapped, threads, emit_mode, output);
+        if (status != 0) {
+            return status;
+        }
+        if (!output.close()) {
+            std::cerr << "Error: Failed writing output" << std::endl;
+            return 1;
+        }
+        std::cout << "Output written to: " << output_file << std::endl;
+        return 0;
+    }
+
+    if (!live_source.empty()) {
+        RowOutput output;
+        if (!output.open(format, depths, emit_mode, direct_io, nullptr)) {
+            return 1;
+        }
+
+        int status = runLive(live_source, books, output);
+        if (status != 0) {
+            return status;
+        }
+        if (!output.close()) {
+            std::cerr << "Error: Failed writing output" << std::endl;
+            return 1;
+        }
+
+        printBooks(books);
+        for (int depth : depths) {
+            std::cout << "Output written to: " << outputFileFor(format, depth) << std::endl;
+        }
+        return 0;
+    }
+
+    if (streaming) {
+        RowOutput output;
+        if (!output.open(format, depths, emit_mode, direct_io, resume)) {
+            return 1;
+        }
+
+        int status = runStreaming(input_file, books, output, checkpoints, resume);
+        if (status != 0) {
+            return status;
+        }
+        if (!output.close()) {
+            std::cerr << "Error: Failed writing output" << std::endl;
+            return 1;
+        }
+
+        printBooks(books);
+        for (int depth : depths) {
+            std::cout << "Output written to: " << outputFileFor(format, depth) << std::endl;
+        }
+        return 0;
+    }
+
+    // Parse input file, on restart from the checkpoint's byte offset; with
+    // checkpoints, keep the offset after each record for them
     std::vector<MBORecord> records;
+    std::vector<uint64_t> positions;
+    bool seek_resume = resume && resume->input_offset != NO_INPUT_OFFSET;
     {
         PerformanceTimer parse_timer("CSV parsing");
-        records = CSVParser::parseFile(input_file);
+        if (!CSVParser::parseFileFrom(input_file, seek_resume ? resume->input_offset : 0, records,
+                                      checkpoints.file.empty() ? nullptr : &positions, parse_threads)) {
+            return 1;
+        }
     }
 
-    if (records.empty()) {
+    if (records.empty() && !resume) {
         std::cerr << "Error: No records found in input file" << std::endl;
         return 1;
     }
 
     std::cout << "Loaded " << records.size() << " MBO records" << std::endl;
-
-    // Initialize orderbook
-    OrderBook orderbook;
-
-    // Open output file
-    std::ofstream output(output_file);
-    if (!output.is_open()) {
-        std::cerr << "Error: Cannot create output file " << output_file << std::endl;
+    // Checkpoints without an offset skip the records they cover
+    size_t first_record = resume && !seek_resume ? static_cast<size_t>(resume->records) : 0;
+    if (first_record > records.size()) {
+        std::cerr << "Error: " << input_file << " ends before the checkpoint" << std::endl;
         return 1;
     }
 
-    // Write CSV header
-    output << ",ts_recv,ts_event,rtype,publisher_id,instrument_id,action,side,depth,price,size,flags,ts_in_delta,sequence,";
-
-    // Write bid/ask level headers
-    for (int i = 0; i < 10; ++i) {
-        output << "bid_px_" << std::setfill('0') << std::setw(2) << i << ","
-               << "bid_sz_" << std::setfill('0') << std::setw(2) << i << ","
-               << "bid_ct_" << std::setfill('0') << std::setw(2) << i << ",";
-
-        output << "ask_px_" << std::setfill('0') << std::setw(2) << i << ","
-               << "ask_sz_" << std::setfill('0') << std::setw(2) << i << ","
-               << "ask_ct_" << std::setfill('0') << std::setw(2) << i;
-
-        if (i < 9) output << ",";
+    // Open the output files (writes the CSV headers)
+    RowOutput output;
+    if (!output.open(format, depths, emit_mode, direct_io, resume)) {
+        return 1;
     }
-    output << ",symbol,order_id\n";
 
     // Process records and generate output
     {
         PerformanceTimer process_timer("Orderbook processing");
 
-        int processed_count = 0;
-        int output_count = 0;
-        int row_index = 0;
+        long processed_count = resume ? static_cast<long>(resume->records) : 0;
+
+        for (size_t i = first_record; i < records.size(); ++i) {
+            const MBORecord& record = records[i];
 
-        for (const auto& record : records) {
-            // Process the record
-            orderbook.processRecord(record);
+            // Process the record in its instrument's book
+            BookEntry& entry = books.route(record);
+            entry.book.processRecord(record);
             processed_count++;
 
-            // Generate output for every record that affects the book
-            // Include the initial 'R' (reset) action as it appears in expected output
-            std::string mbp_line = orderbook.generateMBPOutput(record, row_index);
-            output << mbp_line << "\n";
-            output_count++;
-            row_index++;
+            // Generate output for every record, or only for those that change
+            // the levels of each depth; the initial 'R' (reset) always appears
+            // as in the expected output
+            output.write(entry, record);
+
+            if (checkpoints.due(processed_count)) {
+                checkpoints.save(books, output, record, processed_count, positions[i]);
+            }
 
             // Progress indicator
             if (processed_count % 1000 == 0) {
@@ -87,16 +746,20 @@ int main(int argc, char* argv[]) {
 
         std::cout << "Processing complete!" << std::endl;
         std::cout << "Processed " << processed_count << " MBO records" << std::endl;
-        std::cout << "Generated " << output_count << " MBP records" << std::endl;
+        output.printRows();
     }
 
-    output.close();
+    if (!output.close()) {
+        std::cerr << "Error: Failed writing output" << std::endl;
+        return 1;
+    }
 
     // Final orderbook state
-    std::cout << "\nFinal orderbook state:" << std::endl;
-    orderbook.printBook();
+    printBooks(books);
 
-    std::cout << "Output written to: " << output_file << std::endl;
+    for (int depth : depths) {
+        std::cout << "Output written to: " << outputFileFor(format, depth) << std::endl;
+    }
 
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,134 @@
+#include "mbo_binary.h"
+#include <cstring>
+
+void encodeBinaryRecord(const MBORecord& record, uint32_t symbol_id, BinaryMBORecord& out) {
+    std::memset(&out, 0, sizeof(out));
+    out.ts_recv = record.ts_recv;
+    out.ts_event = record.ts_event;
+    out.price = record.price;
+    out.order_id = static_cast<uint64_t>(record.order_id);
+    out.size = static_cast<uint32_t>(record.size);
+    out.sequence = record.sequence;
+    out.ts_in_delta = record.ts_in_delta;
+    out.instrument_id = record.instrument_id;
+    out.symbol_id = symbol_id;
+    out.publisher_id = record.publisher_id;
+    out.channel_id = record.channel_id;
+    out.rtype = record.rtype;
+    out.action = record.action;
+    out.side = record.side;
+    out.flags = record.flags;
+}
+
+ParseError decodeBinaryRecord(const BinaryMBORecord& in, const std::vector<uint32_t>& symbol_ids, MBORecord& record) {
+    LATENCY_STAGE(Parse);
+    if (in.symbol_id >= symbol_ids.size()) {
+        return ParseError::BadSymbol;
+    }
+
+    record.price = in.price;
+    record.order_id = static_cast<long>(in.order_id);
+    record.size = static_cast<int>(in.size);
+    record.action = in.action;
+    record.side = in.side;
+    record.publisher_id = in.publisher_id;
+    record.instrument_id = in.instrument_id;
+    record.symbol_id = symbol_ids[in.symbol_id];
+    record.ts_recv = in.ts_recv;
+    record.ts_event = in.ts_event;
+    record.sequence = in.sequence;
+    record.ts_in_delta = in.ts_in_delta;
+    record.channel_id = in.channel_id;
+    record.rtype = in.rtype;
+    record.flags = in.flags;
+    return ParseError::None;
+}
+
+bool validBinaryHeader(const BinaryFileHeader& header, uint64_t file_size) {
+    if (std::memcmp(header.magic, BINARY_MBO_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != BINARY_MBO_VERSION || header.record_size != sizeof(BinaryMBORecord)) {
+        return false;
+    }
+    uint64_t records_end = sizeof(BinaryFileHeader) + header.record_count * sizeof(BinaryMBORecord);
+    return header.record_count <= file_size / sizeof(BinaryMBORecord) &&
+           header.symbol_offset == records_end && header.symbol_offset <= file_size;
+}
+
+bool decodeBinarySymbols(const char* data, size_t size, uint32_t symbol_count, std::vector<std::string>& symbols) {
+    symbols.clear();
+    symbols.reserve(symbol_count);
+    size_t pos = 0;
+    for (uint32_t i = 0; i < symbol_count; ++i) {
+        uint16_t length;
+        if (size - pos < sizeof(length)) return false;
+        std::memcpy(&length, data + pos, sizeof(length));
+        pos += sizeof(length);
+        if (size - pos < length) return false;
+        symbols.emplace_back(data + pos, length);
+        pos += length;
+    }
+    return true;
+}
+
+// BinaryMBOWriter Implementation
+BinaryMBOWriter::~BinaryMBOWriter() {
+    close();
+}
+
+bool BinaryMBOWriter::open(const std::string& filename) {
+    close();
+    symbol_table.clear();
+    file_symbol_ids.clear();
+    record_count = 0;
+
+    output.open(filename, std::ios::binary | std::ios::trunc);
+    if (!output.is_open()) {
+        return false;
+    }
+    // Placeholder header, rewritten by close() once the counts are known
+    BinaryFileHeader header = {};
+    output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    return output.good();
+}
+
+void BinaryMBOWriter::write(const MBORecord& record) {
+    if (record.symbol_id >= file_symbol_ids.size()) {
+        file_symbol_ids.resize(record.symbol_id + 1, UINT32_MAX);
+    }
+    uint32_t& symbol_id = file_symbol_ids[record.symbol_id];
+    if (symbol_id == UINT32_MAX) {
+        symbol_id = symbol_table.intern(SymbolTable::global().name(record.symbol_id));
+    }
+
+    BinaryMBORecord out;
+    encodeBinaryRecord(record, symbol_id, out);
+    output.write(reinterpret_cast<const char*>(&out), sizeof(out));
+    record_count++;
+}
+
+bool BinaryMBOWriter::close() {
+    if (!output.is_open()) {
+        return false;
+    }
+
+    for (uint32_t i = 0; i < symbol_table.size(); ++i) {
+        const std::string& name = symbol_table.name(i);
+        uint16_t length = static_cast<uint16_t>(name.size());
+        output.write(reinterpret_cast<const char*>(&length), sizeof(length));
+        output.write(name.data(), length);
+    }
+
+    BinaryFileHeader header = {};
+    std::memcpy(header.magic, BINARY_MBO_MAGIC, sizeof(header.magic));
+    header.version = BINARY_MBO_VERSION;
+    header.record_size = sizeof(BinaryMBORecord);
+    header.record_count = record_count;
+    header.symbol_offset = sizeof(BinaryFileHeader) + record_count * sizeof(BinaryMBORecord);
+    header.symbol_count = static_cast<uint32_t>(symbol_table.size());
+    output.seekp(0);
+    output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    bool ok = output.good();
+    output.close();
+    return ok;
+}
@@ -0,0 +1,89 @@
+#ifndef MBO_BINARY_H
+#define MBO_BINARY_H
+
+#include "orderbook.h"
+#include "symbol_table.h"
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Fixed-width little-endian binary MBO format for cached days.
+//
+// Layout: a 64-byte BinaryFileHeader, record_count 64-byte BinaryMBORecords,
+// then the symbol table (symbol_count entries of u16 length + bytes). Records
+// refer to symbols by index, and timestamps are nanoseconds since the epoch,
+// so decoding a record is a handful of loads with no text parsing.
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "binary MBO format assumes a little-endian host");
+
+constexpr char BINARY_MBO_MAGIC[8] = {'M', 'B', 'O', 'B', 'I', 'N', '\0', '\0'};
+constexpr uint32_t BINARY_MBO_VERSION = 1;
+
+struct BinaryFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t record_size;
+    uint64_t record_count;
+    uint64_t symbol_offset;  // byte offset of the symbol table
+    uint32_t symbol_count;
+    uint8_t reserved[28];
+};
+
+struct BinaryMBORecord {
+    int64_t ts_recv;   // ns since epoch
+    int64_t ts_event;  // ns since epoch
+    int64_t price;     // 1e-9 fixed point
+    uint64_t order_id;
+    uint32_t size;
+    uint32_t sequence;
+    int32_t ts_in_delta;
+    uint32_t instrument_id;
+    uint32_t symbol_id;  // index into the file's symbol table
+    uint16_t publisher_id;
+    uint16_t channel_id;
+    uint8_t rtype;
+    char action;
+    char side;
+    uint8_t flags;
+    uint8_t reserved[4];
+};
+
+static_assert(sizeof(BinaryFileHeader) == 64, "binary MBO header must be 64 bytes");
+static_assert(sizeof(BinaryMBORecord) == 64, "binary MBO record must be 64 bytes");
+
+// Encode record with symbol_id from the file's own symbol table
+void encodeBinaryRecord(const MBORecord& record, uint32_t symbol_id, BinaryMBORecord& out);
+
+// Decode into record, mapping file symbol ids to SymbolTable::global() ids;
+// fails with BadSymbol if symbol_id is out of range
+ParseError decodeBinaryRecord(const BinaryMBORecord& in, const std::vector<uint32_t>& symbol_ids, MBORecord& record);
+
+// Check magic, version and sizes of a header read from a file of file_size bytes
+bool validBinaryHeader(const BinaryFileHeader& header, uint64_t file_size);
+
+// Parse symbol_count entries of the symbol table
+bool decodeBinarySymbols(const char* data, size_t size, uint32_t symbol_count, std::vector<std::string>& symbols);
+
+// Writes records to a binary MBO file; the header is finalized by close()
+class BinaryMBOWriter {
+private:
+    std::ofstream output;
+    SymbolTable symbol_table;
+    std::vector<uint32_t> file_symbol_ids;  // by global symbol id, UINT32_MAX if unseen
+    uint64_t record_count = 0;
+
+public:
+    BinaryMBOWriter() = default;
+    ~BinaryMBOWriter();
+
+    BinaryMBOWriter(const BinaryMBOWriter&) = delete;
+    BinaryMBOWriter& operator=(const BinaryMBOWriter&) = delete;
+
+    bool open(const std::string& filename);
+    void write(const MBORecord& record);
+    bool close();
+
+    uint64_t recordCount() const { return record_count; }
+};
+
+#endif // MBO_BINARY_H
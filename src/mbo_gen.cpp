@@ -0,0 +1,96 @@
+#include "mbo_generator.h"
+#include "mbo_binary.h"
+#include "async_writer.h"
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+static void printUsage(const char* program) {
+    std::cerr << "Usage: " << program << " [--seed N] [--instruments N] [--events N] [--arrival-rate R]"
+              << " [--cancel-rate R] [--trade-ratio R] [--levels N] [--binary] <output_mbo_file>" << std::endl;
+}
+
+// Write a synthetic MBO stream, as CSV or in the binary MBO format, for
+// replays far larger than the sample data
+int main(int argc, char* argv[]) {
+    GeneratorOptions options;
+    bool binary = false;
+    std::string output_file;
+
+    for (int i = 1; i < argc; ++i) {
+        bool has_value = i + 1 < argc;
+        if (std::strcmp(argv[i], "--seed") == 0 && has_value) {
+            options.seed = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--instruments") == 0 && has_value) {
+            options.instruments = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--events") == 0 && has_value) {
+            options.events = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--arrival-rate") == 0 && has_value) {
+            options.arrival_rate = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--cancel-rate") == 0 && has_value) {
+            options.cancel_rate = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--trade-ratio") == 0 && has_value) {
+            options.trade_ratio = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--levels") == 0 && has_value) {
+            options.levels = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--binary") == 0) {
+            binary = true;
+        } else if (argv[i][0] == '-' || !output_file.empty()) {
+            printUsage(argv[0]);
+            return 1;
+        } else {
+            output_file = argv[i];
+        }
+    }
+
+    if (output_file.empty() || options.instruments < 1 || options.levels < 1 || options.arrival_rate < 0 ||
+        options.cancel_rate < 0 || options.trade_ratio < 0) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    if (options.cancel_rate > 0) {
+        std::cout << "Steady state: about "
+                  << static_cast<long>(options.arrival_rate * (1 - options.trade_ratio) / options.cancel_rate)
+                  << " live orders per instrument" << std::endl;
+    }
+
+    MBOGenerator generator(options);
+    MBORecord record;
+    bool ok;
+    {
+        PerformanceTimer timer("Generation");
+        if (binary) {
+            BinaryMBOWriter writer;
+            if (!writer.open(output_file)) {
+                std::cerr << "Error: Cannot create output file " << output_file << std::endl;
+                return 1;
+            }
+            while (generator.next(record)) {
+                writer.write(record);
+            }
+            ok = writer.close();
+        } else {
+            AsyncWriter writer;
+            if (!writer.open(output_file)) {
+                std::cerr << "Error: Cannot create output file " << output_file << std::endl;
+                return 1;
+            }
+            writer.append(MBO_CSV_HEADER, sizeof(MBO_CSV_HEADER) - 1);
+            TimestampCodec timestamps;
+            char line[MBO_LINE_MAX];
+            while (generator.next(record)) {
+                writer.append(line, formatMBOLine(record, timestamps, line));
+            }
+            ok = writer.close();
+        }
+    }
+
+    if (!ok) {
+        std::cerr << "Error: Failed writing " << output_file << std::endl;
+        return 1;
+    }
+    std::cout << "Wrote " << generator.recordsGenerated() << " records (" << generator.tradesGenerated()
+              << " trades, " << generator.liveOrders() << " orders left live) to " << output_file << std::endl;
+    return 0;
+}
@@ -0,0 +1,293 @@
+#include "mbo_generator.h"
+#include "symbol_table.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <string>
+
+namespace {
+
+// Start of the US regular session on the sample data's day
+constexpr const char* SESSION_START = "2025-07-17T13:30:00.000000000Z";
+
+char* writeUnsigned(uint64_t value, char* p) {
+    char digits[20];
+    int n = 0;
+    do {
+        digits[n++] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    } while (value != 0);
+    while (n > 0) {
+        *p++ = digits[--n];
+    }
+    return p;
+}
+
+char* writeSigned(int64_t value, char* p) {
+    if (value < 0) {
+        *p++ = '-';
+        return writeUnsigned(0 - static_cast<uint64_t>(value), p);
+    }
+    return writeUnsigned(static_cast<uint64_t>(value), p);
+}
+
+// Price with all nine fractional digits, as in the source data
+char* writeFullPrice(int64_t price, char* p) {
+    uint64_t magnitude = static_cast<uint64_t>(price);
+    if (price < 0) {
+        *p++ = '-';
+        magnitude = 0 - magnitude;
+    }
+    p = writeUnsigned(magnitude / PRICE_SCALE, p);
+    *p++ = '.';
+    uint64_t fraction = magnitude % PRICE_SCALE;
+    for (int i = 8; i >= 0; --i) {
+        p[i] = static_cast<char>('0' + fraction % 10);
+        fraction /= 10;
+    }
+    return p + 9;
+}
+
+} // namespace
+
+size_t formatMBOLine(const MBORecord& record, TimestampCodec& timestamps, char* out) {
+    char* p = out;
+    p += timestamps.format(record.ts_recv, p);
+    *p++ = ',';
+    p += timestamps.format(record.ts_event, p);
+    *p++ = ',';
+    p = writeUnsigned(record.rtype, p);
+    *p++ = ',';
+    p = writeUnsigned(record.publisher_id, p);
+    *p++ = ',';
+    p = writeUnsigned(record.instrument_id, p);
+    *p++ = ',';
+    *p++ = record.action;
+    *p++ = ',';
+    *p++ = record.side;
+    *p++ = ',';
+    // Resets carry no price
+    if (record.action != 'R') {
+        p = writeFullPrice(record.price, p);
+    }
+    *p++ = ',';
+    p = writeSigned(record.size, p);
+    *p++ = ',';
+    p = writeUnsigned(record.channel_id, p);
+    *p++ = ',';
+    p = writeSigned(record.order_id, p);
+    *p++ = ',';
+    p = writeUnsigned(record.flags, p);
+    *p++ = ',';
+    p = writeSigned(record.ts_in_delta, p);
+    *p++ = ',';
+    p = writeUnsigned(record.sequence, p);
+    *p++ = ',';
+    const std::string& symbol = SymbolTable::global().name(record.symbol_id);
+    size_t length = std::min(symbol.size(), MBO_LINE_MAX - static_cast<size_t>(p - out) - 1);
+    std::memcpy(p, symbol.data(), length);
+    p += length;
+    *p++ = '\n';
+    return p - out;
+}
+
+// MBOGenerator Implementation
+MBOGenerator::MBOGenerator(const GeneratorOptions& generator_options)
+    : options(generator_options), rng_state(generator_options.seed) {
+    options.instruments = std::max(options.instruments, 1);
+    options.levels = std::min(std::max(options.levels, 1), 32767);
+    parseTimestamp(SESSION_START, clock_ns);
+
+    instruments.resize(options.instruments);
+    for (int i = 0; i < options.instruments; ++i) {
+        Instrument& instrument = instruments[i];
+        instrument.instrument_id = 1000 + i;
+        instrument.symbol_id = SymbolTable::global().intern("SYN" + std::to_string(i));
+        // Mid between 5.00 and 500.00, far enough from zero for the deepest bid
+        instrument.mid_tick = options.levels + 500 + static_cast<int64_t>(nextRandom() % 49500);
+        instrument.bids.resize(options.levels);
+        instrument.asks.resize(options.levels);
+    }
+}
+
+// splitmix64: fast, and the same sequence on every platform
+uint64_t MBOGenerator::nextRandom() {
+    uint64_t z = (rng_state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+// Uniform in (0, 1]
+double MBOGenerator::nextUniform() {
+    return static_cast<double>((nextRandom() >> 11) + 1) * 0x1.0p-53;
+}
+
+MBORecord MBOGenerator::makeRecord(const Instrument& instrument, char action, char side, int64_t price, int size,
+                                   long order_id) {
+    MBORecord record{};
+    record.ts_event = clock_ns;
+    record.ts_in_delta = 165000 + static_cast<int32_t>(nextRandom() % 2000);
+    record.ts_recv = clock_ns + record.ts_in_delta;
+    record.rtype = 160;
+    record.publisher_id = 2;
+    record.instrument_id = instrument.instrument_id;
+    record.symbol_id = instrument.symbol_id;
+    record.action = action;
+    record.side = side;
+    record.price = price;
+    record.size = size;
+    record.order_id = order_id;
+    record.flags = action == 'R' ? 8 : 130;
+    record.sequence = sequence;
+    return record;
+}
+
+// Exponential gap to the next event of a process with total_rate per second
+void MBOGenerator::advanceClock(double total_rate) {
+    double gap_ns = -std::log(nextUniform()) / total_rate * 1e9;
+    clock_ns += std::max<int64_t>(1, static_cast<int64_t>(gap_ns));
+}
+
+void MBOGenerator::emitAdd(MBORecord& record) {
+    uint32_t instrument_index = static_cast<uint32_t>(nextRandom() % instruments.size());
+    Instrument& instrument = instruments[instrument_index];
+    char side = (nextRandom() & 1) ? 'B' : 'A';
+
+    // Squaring a uniform draw puts more orders near the top of the book
+    double u = nextUniform();
+    int level = std::min(options.levels - 1, static_cast<int>(options.levels * u * u));
+    int64_t tick = side == 'B' ? instrument.mid_tick - level : instrument.mid_tick + 1 + level;
+
+    // Mostly round lots, some odd lots
+    uint64_t draw = nextRandom();
+    int size = draw % 10 == 0 ? static_cast<int>(draw / 10 % 99) + 1 : static_cast<int>(draw / 10 % 10 + 1) * 100;
+
+    int32_t index;
+    if (!free_orders.empty()) {
+        index = free_orders.back();
+        free_orders.pop_back();
+    } else {
+        index = static_cast<int32_t>(orders.size());
+        orders.emplace_back();
+    }
+
+    Order& order = orders[index];
+    order.order_id = next_order_id;
+    next_order_id += 1 + static_cast<long>(nextRandom() % 4);
+    order.price = tick * DEFAULT_TICK_SIZE;
+    order.size = size;
+    order.instrument = instrument_index;
+    order.live_index = static_cast<uint32_t>(live.size());
+    order.level = static_cast<int16_t>(level);
+    order.side = side;
+    live.push_back(index);
+
+    // Join the back of the level's queue
+    Level& queue = side == 'B' ? instrument.bids[level] : instrument.asks[level];
+    order.prev = queue.tail;
+    order.next = -1;
+    if (queue.tail >= 0) {
+        orders[queue.tail].next = index;
+    } else {
+        queue.head = index;
+    }
+    queue.tail = index;
+
+    record = makeRecord(instrument, 'A', side, order.price, order.size, order.order_id);
+}
+
+void MBOGenerator::unlink(int32_t index) {
+    Order& order = orders[index];
+    Instrument& instrument = instruments[order.instrument];
+    Level& queue = order.side == 'B' ? instrument.bids[order.level] : instrument.asks[order.level];
+    if (order.prev >= 0) {
+        orders[order.prev].next = order.next;
+    } else {
+        queue.head = order.next;
+    }
+    if (order.next >= 0) {
+        orders[order.next].prev = order.prev;
+    } else {
+        queue.tail = order.prev;
+    }
+
+    // Swap-remove from the live list
+    int32_t moved = live.back();
+    live[order.live_index] = moved;
+    orders[moved].live_index = order.live_index;
+    live.pop_back();
+    free_orders.push_back(index);
+}
+
+void MBOGenerator::emitCancel(MBORecord& record) {
+    int32_t index = live[nextRandom() % live.size()];
+    const Order& order = orders[index];
+    record = makeRecord(instruments[order.instrument], 'C', order.side, order.price, order.size, order.order_id);
+    unlink(index);
+}
+
+// Oldest order at the best level of a random side; false if that side is empty
+bool MBOGenerator::emitTrade(MBORecord& record) {
+    Instrument& instrument = instruments[nextRandom() % instruments.size()];
+    char resting = (nextRandom() & 1) ? 'B' : 'A';
+    const std::vector<Level>& queues = resting == 'B' ? instrument.bids : instrument.asks;
+
+    auto best = std::find_if(queues.begin(), queues.end(), [](const Level& level) { return level.head >= 0; });
+    if (best == queues.end()) {
+        return false;
+    }
+
+    int32_t index = best->head;
+    const Order& order = orders[index];
+    char aggressor = resting == 'B' ? 'A' : 'B';
+    record = makeRecord(instrument, 'T', aggressor, order.price, order.size, 0);
+    pending[0] = makeRecord(instrument, 'F', resting, order.price, order.size, order.order_id);
+    pending[1] = makeRecord(instrument, 'C', resting, order.price, order.size, order.order_id);
+    // The triple shares one event time and sequence number
+    pending[0].ts_recv = pending[1].ts_recv = record.ts_recv;
+    pending[0].ts_in_delta = pending[1].ts_in_delta = record.ts_in_delta;
+    pending_count = 2;
+    pending_next = 0;
+    unlink(index);
+    trade_count++;
+    return true;
+}
+
+bool MBOGenerator::next(MBORecord& record) {
+    if (generated >= options.events) {
+        return false;
+    }
+    generated++;
+
+    if (pending_next < pending_count) {
+        record = pending[pending_next++];
+        return true;
+    }
+
+    if (generated <= instruments.size()) {
+        record = makeRecord(instruments[generated - 1], 'R', 'N', 0, 0, 0);
+        return true;
+    }
+
+    double add_rate = options.arrival_rate * static_cast<double>(instruments.size());
+    double trade_rate = add_rate * options.trade_ratio;
+    double cancel_rate = options.cancel_rate * static_cast<double>(live.size());
+    double total_rate = add_rate + trade_rate + cancel_rate;
+    if (total_rate <= 0) {
+        total_rate = 1;
+    }
+    advanceClock(total_rate);
+    sequence++;
+
+    // A trade needs room for its whole triple
+    double u = nextUniform() * total_rate;
+    if (u <= cancel_rate && !live.empty()) {
+        emitCancel(record);
+    } else if (u <= cancel_rate + trade_rate && options.events - generated >= 2 && emitTrade(record)) {
+        // F and C follow
+    } else {
+        emitAdd(record);
+    }
+    return true;
+}
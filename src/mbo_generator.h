@@ -0,0 +1,104 @@
+#ifndef MBO_GENERATOR_H
+#define MBO_GENERATOR_H
+
+#include "orderbook.h"
+#include "timestamp.h"
+#include <cstdint>
+#include <vector>
+
+// Parameters of a synthetic MBO stream. Rates are in events per simulated
+// second; a book settles near arrival_rate * (1 - trade_ratio) / cancel_rate
+// live orders per instrument.
+struct GeneratorOptions {
+    uint64_t seed = 1;
+    int instruments = 1;
+    uint64_t events = 1000000;    // records to generate, including the initial resets
+    double arrival_rate = 1000;   // adds per second per instrument
+    double cancel_rate = 0.1;     // cancels per second per live order
+    double trade_ratio = 0.01;    // T/F/C trade sequences per add
+    int levels = 100;             // price levels per side orders are spread over
+};
+
+// Reproducible MBO workload in the schema of the source data.
+//
+// Each instrument's book is simulated as competing Poisson processes: adds
+// arrive at arrival_rate, each live order is cancelled at cancel_rate, and
+// trades take the oldest order at the best level of a random side, emitted as
+// the T, F, C triple the book expects. New orders rest within levels ticks of
+// a fixed mid, denser towards the top of the book, so the book never crosses.
+// The stream starts with one R per instrument and is a function of the
+// options alone: a given seed yields the same records on every platform.
+class MBOGenerator {
+private:
+    struct Order {
+        long order_id;
+        int64_t price;
+        int size;
+        uint32_t instrument;
+        uint32_t live_index;   // position in live
+        int32_t prev;          // FIFO neighbours within the price level
+        int32_t next;
+        int16_t level;
+        char side;
+    };
+
+    struct Level {
+        int32_t head = -1;
+        int32_t tail = -1;
+    };
+
+    struct Instrument {
+        uint32_t instrument_id;
+        uint32_t symbol_id;
+        int64_t mid_tick;
+        std::vector<Level> bids;  // by tick distance below the mid
+        std::vector<Level> asks;  // by tick distance above the mid
+    };
+
+    GeneratorOptions options;
+    uint64_t rng_state;
+    std::vector<Instrument> instruments;
+    std::vector<Order> orders;        // slab, recycled through free_orders
+    std::vector<int32_t> free_orders;
+    std::vector<int32_t> live;        // live orders, for uniform cancels
+
+    MBORecord pending[3];             // rest of a trade sequence
+    int pending_count = 0;
+    int pending_next = 0;
+
+    uint64_t generated = 0;
+    uint64_t trade_count = 0;
+    int64_t clock_ns;
+    uint32_t sequence = 1000000;
+    long next_order_id = 1000000;
+
+    uint64_t nextRandom();
+    double nextUniform();
+
+    MBORecord makeRecord(const Instrument& instrument, char action, char side, int64_t price, int size, long order_id);
+    void advanceClock(double total_rate);
+
+    void emitAdd(MBORecord& record);
+    void emitCancel(MBORecord& record);
+    bool emitTrade(MBORecord& record);
+    void unlink(int32_t index);
+
+public:
+    explicit MBOGenerator(const GeneratorOptions& generator_options);
+
+    // Next record; false once options.events records were produced
+    bool next(MBORecord& record);
+
+    uint64_t recordsGenerated() const { return generated; }
+    uint64_t tradesGenerated() const { return trade_count; }
+    size_t liveOrders() const { return live.size(); }
+};
+
+// MBO CSV header and row in the layout of data/mbo.csv; the row is written
+// to out (at most MBO_LINE_MAX bytes) with a trailing newline
+constexpr size_t MBO_LINE_MAX = 256;
+inline constexpr char MBO_CSV_HEADER[] =
+    "ts_recv,ts_event,rtype,publisher_id,instrument_id,action,side,price,size,channel_id,order_id,flags,ts_in_delta,sequence,symbol\n";
+size_t formatMBOLine(const MBORecord& record, TimestampCodec& timestamps, char* out);
+
+#endif // MBO_GENERATOR_H
@@ -0,0 +1,324 @@
+#include "mbo_reader.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// MappedFile Implementation
+MappedFile::~MappedFile() {
+    close();
+}
+
+bool MappedFile::open(const std::string& filename) {
+    close();
+
+    fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close();
+        return false;
+    }
+
+    map_size = static_cast<size_t>(st.st_size);
+    if (map_size == 0) {
+        return true; // Empty file: nothing to map
+    }
+
+    void* addr = mmap(nullptr, map_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (addr == MAP_FAILED) {
+        close();
+        return false;
+    }
+    madvise(addr, map_size, MADV_SEQUENTIAL);
+    map_data = static_cast<const char*>(addr);
+    return true;
+}
+
+void MappedFile::close() {
+    if (map_data) {
+        munmap(const_cast<char*>(map_data), map_size);
+    }
+    if (fd >= 0) {
+        ::close(fd);
+    }
+    map_data = nullptr;
+    map_size = 0;
+    fd = -1;
+}
+
+// MBOReader Implementation
+MBOReader::~MBOReader() {
+    close();
+}
+
+bool MBOReader::open(const std::string& filename, ReadMode read_mode, size_t stream_buffer_size) {
+    close();
+    mode = read_mode;
+
+    BinaryFileHeader header;
+    if (mode == ReadMode::Mapped) {
+        if (!file.open(filename)) {
+            return false;
+        }
+        cursor = file.data();
+        end = cursor + file.size();
+
+        if (file.size() >= sizeof(header) && std::memcmp(cursor, BINARY_MBO_MAGIC, sizeof(BINARY_MBO_MAGIC)) == 0) {
+            std::memcpy(&header, cursor, sizeof(header));
+            if (!validBinaryHeader(header, file.size()) ||
+                !loadBinarySymbols(cursor + header.symbol_offset, file.size() - header.symbol_offset,
+                                   header.symbol_count)) {
+                close();
+                return false;
+            }
+            binary = true;
+            binary_remaining = binary_count = header.record_count;
+            cursor += sizeof(header);
+            end = cursor + header.record_count * sizeof(BinaryMBORecord);
+        }
+        return true;
+    }
+
+    stream_fd = ::open(filename.c_str(), O_RDONLY);
+    if (stream_fd < 0) {
+        return false;
+    }
+    posix_fadvise(stream_fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    struct stat st;
+    if (::pread(stream_fd, &header, sizeof(header), 0) == static_cast<ssize_t>(sizeof(header)) &&
+        std::memcmp(header.magic, BINARY_MBO_MAGIC, sizeof(BINARY_MBO_MAGIC)) == 0) {
+        if (fstat(stream_fd, &st) != 0 || !openBinaryStream(header, static_cast<uint64_t>(st.st_size))) {
+            close();
+            return false;
+        }
+        // Whole records per read
+        stream_buffer_size = std::max(stream_buffer_size / sizeof(BinaryMBORecord), size_t(1)) * sizeof(BinaryMBORecord);
+    }
+
+    buffer_size = stream_buffer_size;
+    buffer.reset(new char[buffer_size]);
+    cursor = end = buffer.get();
+    return true;
+}
+
+// Load the symbol table with pread and position the stream at the first record
+bool MBOReader::openBinaryStream(const BinaryFileHeader& header, uint64_t file_size) {
+    if (!validBinaryHeader(header, file_size)) {
+        return false;
+    }
+    std::vector<char> symbols(file_size - header.symbol_offset);
+    if (!symbols.empty() &&
+        ::pread(stream_fd, symbols.data(), symbols.size(), header.symbol_offset) != static_cast<ssize_t>(symbols.size())) {
+        return false;
+    }
+    if (!loadBinarySymbols(symbols.data(), symbols.size(), header.symbol_count) ||
+        ::lseek(stream_fd, sizeof(header), SEEK_SET) < 0) {
+        return false;
+    }
+    binary = true;
+    binary_remaining = binary_count = header.record_count;
+    stream_offset = sizeof(header);
+    return true;
+}
+
+void MBOReader::close() {
+    file.close();
+    if (stream_fd >= 0) {
+        ::close(stream_fd);
+    }
+    stream_fd = -1;
+    stream_eof = false;
+    stream_offset = 0;
+    buffer.reset();
+    buffer_size = 0;
+    cursor = end = nullptr;
+    line_number = 0;
+    skip_header = true;
+    parse_stats = ParseStats();
+    binary = false;
+    binary_remaining = 0;
+    binary_count = 0;
+    binary_symbol_ids.clear();
+}
+
+// Intern the file's symbols into the global table
+bool MBOReader::loadBinarySymbols(const char* data, size_t size, uint32_t symbol_count) {
+    std::vector<std::string> names;
+    if (!decodeBinarySymbols(data, size, symbol_count, names)) {
+        return false;
+    }
+    binary_symbol_ids.clear();
+    for (const std::string& name : names) {
+        binary_symbol_ids.push_back(SymbolTable::global().intern(name));
+    }
+    return true;
+}
+
+// Move the unconsumed tail to the front of the buffer and read more behind it.
+// Returns false when the buffer is already full of a single unterminated line.
+bool MBOReader::refill() {
+    size_t remaining = end - cursor;
+    if (remaining == buffer_size) {
+        return false;
+    }
+    std::memmove(buffer.get(), cursor, remaining);
+    cursor = buffer.get();
+    end = cursor + remaining;
+
+    for (;;) {
+        ssize_t n = ::read(stream_fd, buffer.get() + remaining, buffer_size - remaining);
+        if (n > 0) {
+            end += n;
+            stream_offset += static_cast<uint64_t>(n);
+            return true;
+        }
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        stream_eof = true; // EOF or unrecoverable read error
+        return true;
+    }
+}
+
+bool MBOReader::nextLine(std::string_view& line) {
+    for (;;) {
+        const char* newline = cursor == end ? nullptr
+            : static_cast<const char*>(std::memchr(cursor, '\n', end - cursor));
+        if (newline) {
+            line = std::string_view(cursor, newline - cursor);
+            cursor = newline + 1;
+            return true;
+        }
+
+        if (mode == ReadMode::Mapped || stream_eof) {
+            if (cursor == end) {
+                return false;
+            }
+            line = std::string_view(cursor, end - cursor);
+            cursor = end;
+            return true;
+        }
+
+        if (!refill()) {
+            // Line longer than the buffer: drop it up to the next newline
+            line_number++;
+            parse_stats.lines++;
+            parse_stats.recordError(ParseError::LineTooLong, line_number);
+            skip_header = false;
+            do {
+                cursor = end = buffer.get();
+                refill();
+                newline = static_cast<const char*>(std::memchr(cursor, '\n', end - cursor));
+            } while (!newline && !stream_eof);
+            cursor = newline ? newline + 1 : end;
+        }
+    }
+}
+
+bool MBOReader::nextBinary(MBORecord& record) {
+    while (binary_remaining > 0) {
+        if (static_cast<size_t>(end - cursor) < sizeof(BinaryMBORecord)) {
+            if (mode == ReadMode::Mapped || stream_eof) {
+                return false; // Truncated file
+            }
+            refill();
+            continue;
+        }
+
+        BinaryMBORecord in;
+        std::memcpy(&in, cursor, sizeof(in));
+        cursor += sizeof(in);
+        binary_remaining--;
+        line_number++;
+        parse_stats.lines++;
+
+        ParseError error = decodeBinaryRecord(in, binary_symbol_ids, record);
+        if (error != ParseError::None) {
+            parse_stats.recordError(error, line_number);
+            continue;
+        }
+
+        parse_stats.records++;
+        return true;
+    }
+    return false;
+}
+
+bool MBOReader::next(MBORecord& record) {
+    if (binary) {
+        return nextBinary(record);
+    }
+
+    std::string_view line;
+    while (nextLine(line)) {
+        line_number++;
+
+        if (skip_header) {
+            skip_header = false;
+            continue;
+        }
+        if (line.empty() || line == "\r") {
+            continue;
+        }
+
+        parse_stats.lines++;
+        ParseError error = CSVParser::parseLine(line, record);
+        if (error != ParseError::None) {
+            parse_stats.recordError(error, line_number);
+            continue;
+        }
+
+        parse_stats.records++;
+        return true;
+    }
+    return false;
+}
+
+uint64_t MBOReader::position() const {
+    if (mode == ReadMode::Mapped) {
+        return cursor ? static_cast<uint64_t>(cursor - file.data()) : 0;
+    }
+    return stream_offset - static_cast<uint64_t>(end - cursor);
+}
+
+bool MBOReader::seek(uint64_t offset) {
+    if (binary) {
+        // Only record boundaries
+        uint64_t first = sizeof(BinaryFileHeader);
+        if (offset < first || (offset - first) % sizeof(BinaryMBORecord) != 0 ||
+            (offset - first) / sizeof(BinaryMBORecord) > binary_count) {
+            return false;
+        }
+    }
+
+    if (mode == ReadMode::Mapped) {
+        if (offset > file.size()) {
+            return false;
+        }
+        cursor = file.data() + offset;
+    } else {
+        if (!buffer || ::lseek(stream_fd, static_cast<off_t>(offset), SEEK_SET) < 0) {
+            return false;
+        }
+        cursor = end = buffer.get();
+        stream_offset = offset;
+        stream_eof = false;
+    }
+
+    if (binary) {
+        line_number = (offset - sizeof(BinaryFileHeader)) / sizeof(BinaryMBORecord);
+        binary_remaining = binary_count - line_number;
+    } else {
+        line_number = 0;
+        skip_header = offset == 0;
+    }
+    return true;
+}
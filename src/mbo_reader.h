@@ -0,0 +1,107 @@
+#ifndef MBO_READER_H
+#define MBO_READER_H
+
+#include "orderbook.h"
+#include "mbo_binary.h"
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Read-only memory mapping of a whole input file
+class MappedFile {
+private:
+    const char* map_data = nullptr;
+    size_t map_size = 0;
+    int fd = -1;
+
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const std::string& filename);
+    void close();
+
+    const char* data() const { return map_data; }
+    size_t size() const { return map_size; }
+    bool isOpen() const { return fd >= 0; }
+};
+
+// How MBOReader gets its bytes
+enum class ReadMode {
+    Mapped,    // mmap the whole file (fastest, RSS grows with pages touched)
+    Streaming  // read() into a fixed-size buffer (bounded memory, any length)
+};
+
+// Zero-copy MBO CSV reader: tokenizes lines in place from an mmapped file or a
+// fixed-size read buffer. Malformed lines are skipped and counted in stats()
+// instead of throwing. Reusing the same MBORecord across next() calls
+// allocates nothing per line.
+//
+// Files in the binary MBO format (mbo_binary.h) are detected by their magic
+// and decoded record by record without parsing; stats() line numbers are
+// then record numbers.
+//
+// position() is the byte offset of the next unread record; seek() returns
+// to such an offset, e.g. one saved in a checkpoint. After a seek into a CSV
+// file, stats() line numbers count from the seek point.
+class MBOReader {
+public:
+    static constexpr size_t DEFAULT_BUFFER_SIZE = 1 << 20;
+
+private:
+    MappedFile file;
+    const char* cursor = nullptr;
+    const char* end = nullptr;
+    size_t line_number = 0;
+    bool skip_header = true;
+    ParseStats parse_stats;
+
+    // Streaming mode state
+    ReadMode mode = ReadMode::Mapped;
+    int stream_fd = -1;
+    bool stream_eof = false;
+    uint64_t stream_offset = 0;  // file offset of end
+    std::unique_ptr<char[]> buffer;
+    size_t buffer_size = 0;
+
+    // Binary input state
+    bool binary = false;
+    uint64_t binary_remaining = 0;
+    uint64_t binary_count = 0;
+    std::vector<uint32_t> binary_symbol_ids;  // file symbol index -> global id
+
+    bool nextLine(std::string_view& line);
+    bool refill();
+    bool openBinaryStream(const BinaryFileHeader& header, uint64_t file_size);
+    bool loadBinarySymbols(const char* data, size_t size, uint32_t symbol_count);
+    bool nextBinary(MBORecord& record);
+
+public:
+    MBOReader() = default;
+    ~MBOReader();
+
+    MBOReader(const MBOReader&) = delete;
+    MBOReader& operator=(const MBOReader&) = delete;
+
+    bool open(const std::string& filename, ReadMode read_mode = ReadMode::Mapped,
+              size_t stream_buffer_size = DEFAULT_BUFFER_SIZE);
+    void close();
+
+    // Fill record with the next well-formed line; false at end of input
+    bool next(MBORecord& record);
+
+    // Byte offset of the next record in the file
+    uint64_t position() const;
+
+    // Continue reading at offset, a value of position(); false if out of range
+    bool seek(uint64_t offset);
+
+    bool isBinary() const { return binary; }
+    const ParseStats& stats() const { return parse_stats; }
+};
+
+#endif // MBO_READER_H
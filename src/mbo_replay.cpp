@@ -0,0 +1,126 @@
+#include "live_ingest.h"
+#include "mbo_generator.h"
+#include "mbo_reader.h"
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <sys/socket.h>
+#include <unistd.h>
+
+static void printUsage(const char* program) {
+    std::cerr << "Usage: " << program << " [--speed X] [--socket PATH] <input_mbo_file>" << std::endl;
+    std::cerr << "  --speed X            Replay at X times the recorded ts_recv pace (default 1, 0 for no pacing)" << std::endl;
+    std::cerr << "  --socket PATH        Send to a --live UNIX socket instead of stdout" << std::endl;
+}
+
+// Write all of data to descriptor; sockets must not raise SIGPIPE when the reader goes away
+static bool sendAll(int descriptor, bool is_socket, const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t n = is_socket ? ::send(descriptor, data, size, MSG_NOSIGNAL) : ::write(descriptor, data, size);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        data += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+// Replay an MBO file as a live CSV feed, paced by its ts_recv, for testing
+// the --live mode of the reconstruction tool locally
+int main(int argc, char* argv[]) {
+    double speed = 1.0;
+    std::string socket_path;
+    std::string input_file;
+
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--speed") == 0 && i + 1 < argc) {
+            speed = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--socket") == 0 && i + 1 < argc) {
+            socket_path = argv[++i];
+        } else if (argv[i][0] == '-' || !input_file.empty()) {
+            printUsage(argv[0]);
+            return 1;
+        } else {
+            input_file = argv[i];
+        }
+    }
+    if (input_file.empty() || speed < 0) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    MBOReader reader;
+    if (!reader.open(input_file)) {
+        std::cerr << "Error: Cannot open input file " << input_file << std::endl;
+        return 1;
+    }
+    int descriptor = 1;
+    if (!socket_path.empty()) {
+        descriptor = connectLiveSocket(socket_path);
+        if (descriptor < 0) {
+            std::cerr << "Error: Cannot connect to " << socket_path << std::endl;
+            return 1;
+        }
+    }
+    bool is_socket = !socket_path.empty();
+
+    // Lines already due are sent together; the buffer is sent when full or
+    // before waiting for the next record's time
+    constexpr size_t SEND_BUFFER_SIZE = 1 << 16;
+    std::string pending(MBO_CSV_HEADER);
+    pending.reserve(SEND_BUFFER_SIZE + MBO_LINE_MAX);
+    TimestampCodec timestamps;
+    char line[MBO_LINE_MAX];
+
+    MBORecord record;
+    bool ok = true;
+    bool first = true;
+    int64_t first_ts_recv = 0;
+    int64_t start_ns = LiveIngest::nowNs();
+    uint64_t sent = 0;
+
+    while (ok && reader.next(record)) {
+        if (first) {
+            first_ts_recv = record.ts_recv;
+            first = false;
+        }
+        if (speed > 0) {
+            int64_t due_ns = start_ns + static_cast<int64_t>((record.ts_recv - first_ts_recv) / speed);
+            if (due_ns > LiveIngest::nowNs()) {
+                ok = sendAll(descriptor, is_socket, pending.data(), pending.size());
+                pending.clear();
+                unsigned attempts = 0;
+                while (ok && due_ns > LiveIngest::nowNs()) {
+                    backoff(attempts);
+                }
+            }
+        }
+        pending.append(line, formatMBOLine(record, timestamps, line));
+        sent++;
+        if (pending.size() >= SEND_BUFFER_SIZE) {
+            ok = ok && sendAll(descriptor, is_socket, pending.data(), pending.size());
+            pending.clear();
+        }
+    }
+    ok = ok && sendAll(descriptor, is_socket, pending.data(), pending.size());
+    if (is_socket) {
+        ::close(descriptor);
+    }
+
+    if (!ok) {
+        std::cerr << "Error: The live feed reader went away after " << sent << " records" << std::endl;
+        return 1;
+    }
+    const ParseStats& stats = reader.stats();
+    if (stats.errors > 0) {
+        std::cerr << "Skipped " << stats.errors << " malformed line(s)" << std::endl;
+    }
+    std::cerr << "Replayed " << sent << " records" << std::endl;
+    return 0;
+}
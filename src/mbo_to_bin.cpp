@@ -0,0 +1,46 @@
+#include "mbo_reader.h"
+#include "mbo_binary.h"
+#include <iostream>
+
+// Convert an MBO CSV file to the binary MBO format so repeated runs on the
+// same day skip text parsing
+int main(int argc, char* argv[]) {
+    if (argc != 3) {
+        std::cerr << "Usage: " << argv[0] << " <input_mbo_file.csv> <output_mbo_file.bin>" << std::endl;
+        return 1;
+    }
+
+    MBOReader reader;
+    if (!reader.open(argv[1], ReadMode::Streaming)) {
+        std::cerr << "Error: Cannot open file " << argv[1] << std::endl;
+        return 1;
+    }
+    if (reader.isBinary()) {
+        std::cerr << "Error: " << argv[1] << " is already in binary format" << std::endl;
+        return 1;
+    }
+
+    BinaryMBOWriter writer;
+    if (!writer.open(argv[2])) {
+        std::cerr << "Error: Cannot create output file " << argv[2] << std::endl;
+        return 1;
+    }
+
+    PerformanceTimer timer("Conversion");
+    MBORecord record;
+    while (reader.next(record)) {
+        writer.write(record);
+    }
+    if (!writer.close()) {
+        std::cerr << "Error: Failed writing " << argv[2] << std::endl;
+        return 1;
+    }
+
+    const ParseStats& stats = reader.stats();
+    if (stats.errors > 0) {
+        std::cerr << "Skipped " << stats.errors << " malformed line(s) (first at line "
+                  << stats.first_error_line << ": " << parseErrorName(stats.first_error) << ")" << std::endl;
+    }
+    std::cout << "Wrote " << writer.recordCount() << " records to " << argv[2] << std::endl;
+    return 0;
+}
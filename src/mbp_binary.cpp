@@ -0,0 +1,407 @@
+#include "mbp_binary.h"
+#include "mbo_binary.h"
+#include "mbp_formatter.h"
+#include "timestamp.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+inline void copyLevels(const TopLevels& view, MBPLevel* out) {
+    // Books viewing deeper than MBP-10 fill only the record's levels
+    int count = std::min(view.count, BOOK_DEPTH);
+    for (int i = 0; i < count; ++i) {
+        out[i].price = view.levels[i].price;
+        out[i].size = static_cast<uint32_t>(view.levels[i].total_size);
+        out[i].count = static_cast<uint32_t>(view.levels[i].order_count);
+    }
+}
+
+inline char* writeText(char* out, std::string_view text) {
+    std::memcpy(out, text.data(), text.size());
+    return out + text.size();
+}
+
+inline char* writeLevel(char* out, const MBPLevel& level) {
+    if (level.count == 0) {
+        return writeText(out, ",0,0");
+    }
+    out += formatPrice(level.price, out);
+    *out++ = ',';
+    out = writeUnsigned(out, level.size);
+    *out++ = ',';
+    return writeUnsigned(out, level.count);
+}
+
+// Row fields in column order
+void toColumns(const BinaryMBPRecord& record, int64_t* values) {
+    int c = 0;
+    values[c++] = record.ts_recv;
+    values[c++] = record.ts_event;
+    values[c++] = record.price;
+    values[c++] = static_cast<int64_t>(record.order_id);
+    values[c++] = record.size;
+    values[c++] = record.sequence;
+    values[c++] = record.ts_in_delta;
+    values[c++] = record.instrument_id;
+    values[c++] = record.symbol_id;
+    values[c++] = record.publisher_id;
+    values[c++] = record.rtype;
+    values[c++] = record.action;
+    values[c++] = record.side;
+    values[c++] = record.depth;
+    values[c++] = record.flags;
+    for (int i = 0; i < BOOK_DEPTH; ++i) {
+        values[c++] = record.bids[i].price;
+        values[c++] = record.bids[i].size;
+        values[c++] = record.bids[i].count;
+        values[c++] = record.asks[i].price;
+        values[c++] = record.asks[i].size;
+        values[c++] = record.asks[i].count;
+    }
+}
+
+void fromColumns(const int64_t* values, BinaryMBPRecord& record) {
+    std::memset(&record, 0, sizeof(record));
+    int c = 0;
+    record.ts_recv = values[c++];
+    record.ts_event = values[c++];
+    record.price = values[c++];
+    record.order_id = static_cast<uint64_t>(values[c++]);
+    record.size = static_cast<uint32_t>(values[c++]);
+    record.sequence = static_cast<uint32_t>(values[c++]);
+    record.ts_in_delta = static_cast<int32_t>(values[c++]);
+    record.instrument_id = static_cast<uint32_t>(values[c++]);
+    record.symbol_id = static_cast<uint32_t>(values[c++]);
+    record.publisher_id = static_cast<uint16_t>(values[c++]);
+    record.rtype = static_cast<uint8_t>(values[c++]);
+    record.action = static_cast<char>(values[c++]);
+    record.side = static_cast<char>(values[c++]);
+    record.depth = static_cast<uint8_t>(values[c++]);
+    record.flags = static_cast<uint8_t>(values[c++]);
+    for (int i = 0; i < BOOK_DEPTH; ++i) {
+        record.bids[i].price = values[c++];
+        record.bids[i].size = static_cast<uint32_t>(values[c++]);
+        record.bids[i].count = static_cast<uint32_t>(values[c++]);
+        record.asks[i].price = values[c++];
+        record.asks[i].size = static_cast<uint32_t>(values[c++]);
+        record.asks[i].count = static_cast<uint32_t>(values[c++]);
+    }
+}
+
+// Delta to the previous value as a zigzag LEB128 varint (wrapping arithmetic)
+inline void putDelta(std::vector<uint8_t>& out, int64_t value, int64_t previous) {
+    uint64_t delta = static_cast<uint64_t>(value) - static_cast<uint64_t>(previous);
+    uint64_t zigzag = (delta << 1) ^ static_cast<uint64_t>(static_cast<int64_t>(delta) >> 63);
+    while (zigzag >= 0x80) {
+        out.push_back(static_cast<uint8_t>(zigzag | 0x80));
+        zigzag >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(zigzag));
+}
+
+inline bool getDelta(const uint8_t*& p, const uint8_t* last, int64_t& value) {
+    uint64_t zigzag = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (p == last) return false;
+        uint8_t byte = *p++;
+        zigzag |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            uint64_t delta = (zigzag >> 1) ^ (0 - (zigzag & 1));
+            value = static_cast<int64_t>(static_cast<uint64_t>(value) + delta);
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+void makeMBPRecord(const MBORecord& record, const OrderBook& book, uint32_t symbol_id, BinaryMBPRecord& out) {
+    LATENCY_STAGE(Format);
+    std::memset(&out, 0, sizeof(out));
+    out.ts_recv = record.ts_recv;
+    out.ts_event = record.ts_event;
+    out.price = record.price;
+    out.order_id = static_cast<uint64_t>(record.order_id);
+    out.size = static_cast<uint32_t>(record.size);
+    out.sequence = record.sequence;
+    out.ts_in_delta = record.ts_in_delta;
+    out.instrument_id = record.instrument_id;
+    out.symbol_id = symbol_id;
+    out.publisher_id = record.publisher_id;
+    out.rtype = 10;  // MBP-10
+    out.action = record.action;
+    out.side = record.side;
+    out.depth = static_cast<uint8_t>(book.lastChange().depth(BOOK_DEPTH));
+    out.flags = record.flags;
+    copyLevels(book.topBids(), out.bids);
+    copyLevels(book.topAsks(), out.asks);
+}
+
+size_t formatMBPRecord(const BinaryMBPRecord& record, long row_index, std::string_view symbol, char* out) {
+    thread_local TimestampCodec timestamps;
+    char* p = writeSigned(out, row_index);
+    *p++ = ',';
+    p += timestamps.format(record.ts_recv, p);
+    *p++ = ',';
+    p += timestamps.format(record.ts_event, p);
+    *p++ = ',';
+    p = writeUnsigned(p, record.rtype);
+    *p++ = ',';
+    p = writeUnsigned(p, record.publisher_id);
+    *p++ = ',';
+    p = writeUnsigned(p, record.instrument_id);
+    *p++ = ',';
+    *p++ = record.action;
+    *p++ = ',';
+    *p++ = record.side;
+    *p++ = ',';
+    p = writeUnsigned(p, record.depth);
+    *p++ = ',';
+    p += formatPrice(record.price, p);
+    *p++ = ',';
+    p = writeUnsigned(p, record.size);
+    *p++ = ',';
+    p = writeUnsigned(p, record.flags);
+    *p++ = ',';
+    p = writeSigned(p, record.ts_in_delta);
+    *p++ = ',';
+    p = writeUnsigned(p, record.sequence);
+    *p++ = ',';
+
+    for (int i = 0; i < BOOK_DEPTH; ++i) {
+        p = writeLevel(p, record.bids[i]);
+        *p++ = ',';
+        p = writeLevel(p, record.asks[i]);
+        if (i < BOOK_DEPTH - 1) *p++ = ',';
+    }
+
+    *p++ = ',';
+    p = writeText(p, symbol);
+    *p++ = ',';
+    p = writeSigned(p, static_cast<int64_t>(record.order_id));
+    *p++ = '\n';
+    return p - out;
+}
+
+// MBPFileWriter Implementation
+MBPFileWriter::~MBPFileWriter() {
+    close();
+}
+
+bool MBPFileWriter::open(const std::string& filename, MBPLayout file_layout, uint32_t rows_per_chunk) {
+    close();
+    layout = file_layout;
+    chunk_rows = rows_per_chunk > 0 ? rows_per_chunk : DEFAULT_CHUNK_ROWS;
+    record_count = 0;
+    symbol_table.clear();
+    file_symbol_ids.clear();
+    chunk.clear();
+    if (layout == MBPLayout::Columnar) {
+        chunk.reserve(chunk_rows);
+    }
+
+    output.open(filename, std::ios::binary | std::ios::trunc);
+    if (!output.is_open()) {
+        return false;
+    }
+    // Placeholder header, rewritten by close() once the counts are known
+    MBPFileHeader header = {};
+    output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    return output.good();
+}
+
+uint32_t MBPFileWriter::symbolId(uint32_t global_id) {
+    if (global_id >= file_symbol_ids.size()) {
+        file_symbol_ids.resize(global_id + 1, UINT32_MAX);
+    }
+    uint32_t& id = file_symbol_ids[global_id];
+    if (id == UINT32_MAX) {
+        id = symbol_table.intern(SymbolTable::global().name(global_id));
+    }
+    return id;
+}
+
+void MBPFileWriter::write(const MBORecord& record, const OrderBook& book) {
+    BinaryMBPRecord row;
+    makeMBPRecord(record, book, symbolId(record.symbol_id), row);
+    record_count++;
+
+    if (layout == MBPLayout::Fixed) {
+        output.write(reinterpret_cast<const char*>(&row), sizeof(row));
+        return;
+    }
+    chunk.push_back(row);
+    if (chunk.size() == chunk_rows) {
+        flushChunk();
+    }
+}
+
+// Chunk: u32 row count, u32 byte size of each column, then the columns
+void MBPFileWriter::flushChunk() {
+    if (chunk.empty()) {
+        return;
+    }
+
+    int64_t previous[MBP_COLUMN_COUNT] = {};
+    int64_t values[MBP_COLUMN_COUNT];
+    for (auto& column : columns) {
+        column.clear();
+    }
+    for (const BinaryMBPRecord& row : chunk) {
+        toColumns(row, values);
+        for (int c = 0; c < MBP_COLUMN_COUNT; ++c) {
+            putDelta(columns[c], values[c], previous[c]);
+            previous[c] = values[c];
+        }
+    }
+
+    uint32_t sizes[MBP_COLUMN_COUNT + 1];
+    sizes[0] = static_cast<uint32_t>(chunk.size());
+    for (int c = 0; c < MBP_COLUMN_COUNT; ++c) {
+        sizes[c + 1] = static_cast<uint32_t>(columns[c].size());
+    }
+    output.write(reinterpret_cast<const char*>(sizes), sizeof(sizes));
+    for (const auto& column : columns) {
+        output.write(reinterpret_cast<const char*>(column.data()), column.size());
+    }
+    chunk.clear();
+}
+
+bool MBPFileWriter::close() {
+    if (!output.is_open()) {
+        return false;
+    }
+    if (layout == MBPLayout::Columnar) {
+        flushChunk();
+    }
+
+    MBPFileHeader header = {};
+    header.symbol_offset = static_cast<uint64_t>(output.tellp());
+    for (uint32_t i = 0; i < symbol_table.size(); ++i) {
+        const std::string& name = symbol_table.name(i);
+        uint16_t length = static_cast<uint16_t>(name.size());
+        output.write(reinterpret_cast<const char*>(&length), sizeof(length));
+        output.write(name.data(), length);
+    }
+
+    std::memcpy(header.magic, BINARY_MBP_MAGIC, sizeof(header.magic));
+    header.version = BINARY_MBP_VERSION;
+    header.layout = layout;
+    header.record_size = sizeof(BinaryMBPRecord);
+    header.chunk_rows = layout == MBPLayout::Columnar ? chunk_rows : 0;
+    header.record_count = record_count;
+    header.symbol_count = static_cast<uint32_t>(symbol_table.size());
+    output.seekp(0);
+    output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    bool ok = output.good();
+    output.close();
+    return ok;
+}
+
+// MBPReader Implementation
+bool MBPReader::open(const std::string& filename) {
+    close();
+    if (!file.open(filename) || file.size() < sizeof(header)) {
+        close();
+        return false;
+    }
+
+    std::memcpy(&header, file.data(), sizeof(header));
+    bool valid = std::memcmp(header.magic, BINARY_MBP_MAGIC, sizeof(header.magic)) == 0 &&
+                 header.version == BINARY_MBP_VERSION && header.record_size == sizeof(BinaryMBPRecord) &&
+                 (header.layout == MBPLayout::Fixed || header.layout == MBPLayout::Columnar) &&
+                 header.symbol_offset >= sizeof(header) && header.symbol_offset <= file.size();
+    if (valid && header.layout == MBPLayout::Fixed) {
+        valid = header.record_count == (header.symbol_offset - sizeof(header)) / sizeof(BinaryMBPRecord);
+    }
+    if (!valid || !decodeBinarySymbols(file.data() + header.symbol_offset, file.size() - header.symbol_offset,
+                                       header.symbol_count, symbols)) {
+        close();
+        return false;
+    }
+
+    cursor = file.data() + sizeof(header);
+    end = file.data() + header.symbol_offset;
+    remaining = header.record_count;
+    return true;
+}
+
+void MBPReader::close() {
+    file.close();
+    header = MBPFileHeader();
+    symbols.clear();
+    cursor = end = nullptr;
+    remaining = 0;
+    corrupt = false;
+    chunk.clear();
+    chunk_pos = 0;
+}
+
+bool MBPReader::decodeChunk() {
+    uint32_t sizes[MBP_COLUMN_COUNT + 1];
+    if (static_cast<size_t>(end - cursor) < sizeof(sizes)) {
+        return false;
+    }
+    std::memcpy(sizes, cursor, sizeof(sizes));
+    cursor += sizeof(sizes);
+
+    uint32_t rows = sizes[0];
+    if (rows == 0 || rows > remaining) {
+        return false;
+    }
+
+    // Column start positions
+    const uint8_t* column_pos[MBP_COLUMN_COUNT];
+    const uint8_t* column_end[MBP_COLUMN_COUNT];
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(cursor);
+    const uint8_t* last = reinterpret_cast<const uint8_t*>(end);
+    for (int c = 0; c < MBP_COLUMN_COUNT; ++c) {
+        if (static_cast<size_t>(last - p) < sizes[c + 1]) {
+            return false;
+        }
+        column_pos[c] = p;
+        p += sizes[c + 1];
+        column_end[c] = p;
+    }
+    cursor = reinterpret_cast<const char*>(p);
+
+    chunk.resize(rows);
+    int64_t values[MBP_COLUMN_COUNT] = {};
+    for (uint32_t row = 0; row < rows; ++row) {
+        for (int c = 0; c < MBP_COLUMN_COUNT; ++c) {
+            if (!getDelta(column_pos[c], column_end[c], values[c])) {
+                return false;
+            }
+        }
+        fromColumns(values, chunk[row]);
+    }
+    chunk_pos = 0;
+    return true;
+}
+
+bool MBPReader::next(BinaryMBPRecord& record) {
+    if (remaining == 0 || corrupt) {
+        return false;
+    }
+
+    if (header.layout == MBPLayout::Fixed) {
+        std::memcpy(&record, cursor, sizeof(record));
+        cursor += sizeof(record);
+    } else {
+        if (chunk_pos == chunk.size() && !decodeChunk()) {
+            corrupt = true;
+            return false;
+        }
+        record = chunk[chunk_pos++];
+    }
+
+    remaining--;
+    if (record.symbol_id >= symbols.size()) {
+        corrupt = true;
+        return false;
+    }
+    return true;
+}
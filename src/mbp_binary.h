@@ -0,0 +1,148 @@
+#ifndef MBP_BINARY_H
+#define MBP_BINARY_H
+
+#include "orderbook.h"
+#include "mbo_reader.h"
+#include "symbol_table.h"
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Binary MBP-10 output, built from the same snapshot as the CSV rows.
+//
+// A file is a 64-byte MBPFileHeader, the row data, then the symbol table (as
+// in the binary MBO format). Two layouts share the header:
+//  - Fixed: one 384-byte BinaryMBPRecord per row, readable in place.
+//  - Columnar: chunks of up to chunk_rows rows. Each of the MBP_COLUMN_COUNT
+//    columns is stored as zigzag varints of the delta to the previous row of
+//    the chunk, so unchanged prices, sizes and counts take one byte.
+// Empty levels are all zero (a live level always has count > 0).
+constexpr char BINARY_MBP_MAGIC[8] = {'M', 'B', 'P', '1', '0', 'B', 'I', 'N'};
+constexpr uint32_t BINARY_MBP_VERSION = 1;
+
+enum class MBPLayout : uint32_t {
+    Fixed = 0,
+    Columnar = 1
+};
+
+struct MBPFileHeader {
+    char magic[8];
+    uint32_t version;
+    MBPLayout layout;
+    uint32_t record_size;
+    uint32_t chunk_rows;
+    uint64_t record_count;
+    uint64_t symbol_offset;
+    uint32_t symbol_count;
+    uint8_t reserved[20];
+};
+
+struct MBPLevel {
+    int64_t price;
+    uint32_t size;
+    uint32_t count;
+};
+
+struct BinaryMBPRecord {
+    int64_t ts_recv;   // ns since epoch
+    int64_t ts_event;  // ns since epoch
+    int64_t price;     // 1e-9 fixed point
+    uint64_t order_id;
+    uint32_t size;
+    uint32_t sequence;
+    int32_t ts_in_delta;
+    uint32_t instrument_id;
+    uint32_t symbol_id;
+    uint16_t publisher_id;
+    uint8_t rtype;
+    char action;
+    char side;
+    uint8_t depth;
+    uint8_t flags;
+    uint8_t reserved[5];
+    MBPLevel bids[BOOK_DEPTH];
+    MBPLevel asks[BOOK_DEPTH];
+};
+
+static_assert(sizeof(MBPFileHeader) == 64, "binary MBP header must be 64 bytes");
+static_assert(sizeof(BinaryMBPRecord) == 64 + 2 * BOOK_DEPTH * sizeof(MBPLevel), "unexpected BinaryMBPRecord padding");
+
+// 15 row fields plus price/size/count per side and level
+constexpr int MBP_COLUMN_COUNT = 15 + 6 * BOOK_DEPTH;
+
+// Snapshot of book after record; symbol_id is the file's own symbol index
+void makeMBPRecord(const MBORecord& record, const OrderBook& book, uint32_t symbol_id, BinaryMBPRecord& out);
+
+// Format as the CSV row MBPFormatter writes (with '\n'); out needs MBP_ROW_MAX_SIZE
+// plus the symbol length. Returns characters written.
+constexpr size_t MBP_ROW_MAX_SIZE = 1536;
+size_t formatMBPRecord(const BinaryMBPRecord& record, long row_index, std::string_view symbol, char* out);
+
+// Writes MBP-10 snapshots in either layout; the header is finalized by close()
+class MBPFileWriter {
+public:
+    static constexpr uint32_t DEFAULT_CHUNK_ROWS = 4096;
+
+private:
+    std::ofstream output;
+    MBPLayout layout = MBPLayout::Fixed;
+    uint32_t chunk_rows = DEFAULT_CHUNK_ROWS;
+    uint64_t record_count = 0;
+
+    SymbolTable symbol_table;
+    std::vector<uint32_t> file_symbol_ids;  // by global symbol id, UINT32_MAX if unseen
+
+    // Columnar layout: rows of the open chunk and per-column encode buffers
+    std::vector<BinaryMBPRecord> chunk;
+    std::vector<uint8_t> columns[MBP_COLUMN_COUNT];
+
+    uint32_t symbolId(uint32_t global_id);
+    void flushChunk();
+
+public:
+    MBPFileWriter() = default;
+    ~MBPFileWriter();
+
+    MBPFileWriter(const MBPFileWriter&) = delete;
+    MBPFileWriter& operator=(const MBPFileWriter&) = delete;
+
+    bool open(const std::string& filename, MBPLayout file_layout, uint32_t rows_per_chunk = DEFAULT_CHUNK_ROWS);
+    void write(const MBORecord& record, const OrderBook& book);
+    bool close();
+
+    uint64_t recordCount() const { return record_count; }
+};
+
+// Reads either layout back, one BinaryMBPRecord per row in file order
+class MBPReader {
+private:
+    MappedFile file;
+    MBPFileHeader header = {};
+    std::vector<std::string> symbols;
+    const char* cursor = nullptr;
+    const char* end = nullptr;
+    uint64_t remaining = 0;
+    bool corrupt = false;
+
+    // Columnar layout: the decoded current chunk
+    std::vector<BinaryMBPRecord> chunk;
+    size_t chunk_pos = 0;
+
+    bool decodeChunk();
+
+public:
+    bool open(const std::string& filename);
+    void close();
+
+    // Next row; false at the end of the file or on a corrupt chunk
+    bool next(BinaryMBPRecord& record);
+
+    MBPLayout layout() const { return header.layout; }
+    uint64_t recordCount() const { return header.record_count; }
+    const std::string& symbol(uint32_t id) const { return symbols[id]; }
+    bool failed() const { return corrupt; }
+};
+
+#endif // MBP_BINARY_H
@@ -0,0 +1,187 @@
+#include "mbp_formatter.h"
+#include "symbol_table.h"
+#include <cstring>
+#include <iomanip>
+
+namespace {
+
+// "00" .. "99" for two digits per step
+constexpr char DIGIT_PAIRS[] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+inline char* writeText(char* out, std::string_view text) {
+    std::memcpy(out, text.data(), text.size());
+    return out + text.size();
+}
+
+} // namespace
+
+char* writeUnsigned(char* out, uint64_t value) {
+    char digits[20];
+    char* p = digits + sizeof(digits);
+    while (value >= 100) {
+        p -= 2;
+        std::memcpy(p, DIGIT_PAIRS + (value % 100) * 2, 2);
+        value /= 100;
+    }
+    if (value >= 10) {
+        p -= 2;
+        std::memcpy(p, DIGIT_PAIRS + value * 2, 2);
+    } else {
+        *--p = static_cast<char>('0' + value);
+    }
+
+    size_t length = digits + sizeof(digits) - p;
+    std::memcpy(out, p, length);
+    return out + length;
+}
+
+char* writeSigned(char* out, int64_t value) {
+    uint64_t magnitude = static_cast<uint64_t>(value);
+    if (value < 0) {
+        *out++ = '-';
+        magnitude = 0 - magnitude;
+    }
+    return writeUnsigned(out, magnitude);
+}
+
+void writeMBPHeader(std::ostream& output, int depth) {
+    output << ",ts_recv,ts_event,rtype,publisher_id,instrument_id,action,side,depth,price,size,flags,ts_in_delta,sequence,";
+
+    // Write bid/ask level headers
+    for (int i = 0; i < depth; ++i) {
+        output << "bid_px_" << std::setfill('0') << std::setw(2) << i << ","
+               << "bid_sz_" << std::setfill('0') << std::setw(2) << i << ","
+               << "bid_ct_" << std::setfill('0') << std::setw(2) << i << ",";
+
+        output << "ask_px_" << std::setfill('0') << std::setw(2) << i << ","
+               << "ask_sz_" << std::setfill('0') << std::setw(2) << i << ","
+               << "ask_ct_" << std::setfill('0') << std::setw(2) << i;
+
+        if (i < depth - 1) output << ",";
+    }
+    output << ",symbol,order_id\n";
+}
+
+// BasicMBPFormatter Implementation
+template <int Depth>
+BasicMBPFormatter<Depth>::BasicMBPFormatter() : buffer(512 + 2 * Depth * (LEVEL_TEXT_SIZE + 1)) {
+}
+
+template <int Depth>
+void BasicMBPFormatter<Depth>::formatLevel(LevelText& out, const TopLevels& view, int index) {
+    char* p = out.text;
+    if (index < view.count) {
+        const PriceLevel& level = view.levels[index];
+        p += formatPrice(level.price, p);
+        *p++ = ',';
+        p = writeSigned(p, level.total_size);
+        *p++ = ',';
+        p = writeSigned(p, level.order_count);
+    } else {
+        p = writeText(p, ",0,0");
+    }
+    out.length = static_cast<uint8_t>(p - out.text);
+}
+
+template <int Depth>
+std::string_view BasicMBPFormatter<Depth>::formatRow(const MBORecord& record, long row_index, const OrderBook& book) {
+    std::string_view fields = formatFields(record, book);
+
+    // Index written right before the fields in the space reserved for it
+    char digits[INDEX_SPACE];
+    char* end = writeSigned(digits, row_index);
+    size_t length = end - digits;
+    char* p = const_cast<char*>(fields.data()) - length - 1;
+    std::memcpy(p, digits, length);
+    p[length] = ',';
+    return std::string_view(p, fields.size() + length + 1);
+}
+
+template <int Depth>
+std::string_view BasicMBPFormatter<Depth>::formatFields(const MBORecord& record, const OrderBook& book) {
+    LATENCY_STAGE(Format);
+    if (record.symbol_id != symbol_id) {
+        symbol_id = record.symbol_id;
+        symbol_text = SymbolTable::global().name(symbol_id);
+    }
+
+    // Fixed columns + 2 * Depth level texts + symbol; grows only for unusually long symbols
+    size_t needed = INDEX_SPACE + 256 + 2 * Depth * (LEVEL_TEXT_SIZE + 1) + 2 * TIMESTAMP_LENGTH + symbol_text.size();
+    if (buffer.size() < needed) {
+        buffer.resize(needed);
+    }
+
+    // Refresh only the level texts that changed since the previous row
+    const TopLevels& bids = book.topBids();
+    const TopLevels& asks = book.topAsks();
+    uint64_t bid_mask = book.lastChange().bid_mask & levelMask(Depth);
+    uint64_t ask_mask = book.lastChange().ask_mask & levelMask(Depth);
+    if (!primed) {
+        bid_mask = ask_mask = levelMask(Depth);
+        primed = true;
+    }
+    for (; bid_mask; bid_mask &= bid_mask - 1) {
+        int i = __builtin_ctzll(bid_mask);
+        formatLevel(bid_text[i], bids, i);
+    }
+    for (; ask_mask; ask_mask &= ask_mask - 1) {
+        int i = __builtin_ctzll(ask_mask);
+        formatLevel(ask_text[i], asks, i);
+    }
+
+    // Basic record information (columns 1-13)
+    char* start = buffer.data() + INDEX_SPACE;
+    char* p = start;
+    p += timestamps.format(record.ts_recv, p);
+    *p++ = ',';
+    p += timestamps.format(record.ts_event, p);
+    *p++ = ',';
+    p = writeUnsigned(p, RTYPE);
+    *p++ = ',';
+    p = writeSigned(p, record.publisher_id);
+    *p++ = ',';
+    p = writeSigned(p, record.instrument_id);
+    *p++ = ',';
+    *p++ = record.action;
+    *p++ = ',';
+    *p++ = record.side;
+    *p++ = ',';
+    p = writeUnsigned(p, book.lastChange().depth(Depth));
+    *p++ = ',';
+    p += formatPrice(record.price, p);
+    *p++ = ',';
+    p = writeSigned(p, record.size);
+    *p++ = ',';
+    p = writeSigned(p, record.flags);
+    *p++ = ',';
+    p = writeSigned(p, record.ts_in_delta);
+    *p++ = ',';
+    p = writeSigned(p, record.sequence);
+    *p++ = ',';
+
+    // Depth levels of bid/ask data copied from the cached texts
+    for (int i = 0; i < Depth; ++i) {
+        std::memcpy(p, bid_text[i].text, bid_text[i].length);
+        p += bid_text[i].length;
+        *p++ = ',';
+        std::memcpy(p, ask_text[i].text, ask_text[i].length);
+        p += ask_text[i].length;
+        if (i < Depth - 1) *p++ = ',';
+    }
+
+    // Symbol and order_id
+    *p++ = ',';
+    p = writeText(p, symbol_text);
+    *p++ = ',';
+    p = writeSigned(p, record.order_id);
+    *p++ = '\n';
+
+    return std::string_view(start, p - start);
+}
+
+template class BasicMBPFormatter<1>;
+template class BasicMBPFormatter<BOOK_DEPTH>;
+template class BasicMBPFormatter<MAX_BOOK_DEPTH>;
@@ -0,0 +1,96 @@
+#ifndef MBP_FORMATTER_H
+#define MBP_FORMATTER_H
+
+#include "orderbook.h"
+#include "timestamp.h"
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Allocation-free MBP-N CSV row formatter for N = Depth levels per side.
+//
+// Depth is a template parameter so the per-level loops have a fixed trip
+// count and an MBP-1 formatter touches only the best level; MBP-1, MBP-10
+// and MBP-50 are instantiated in mbp_formatter.cpp. The book's view depth
+// must be at least Depth. Rows are written into a reusable char buffer with
+// hand-written integer and fixed-point conversion. The text of each level
+// ("price,size,count") is cached between rows and only the view indices
+// reported by OrderBook::lastChange() are reformatted; the rest is copied
+// from the previous row. The formatter must therefore see every row of one
+// book (call invalidate() otherwise).
+template <int Depth>
+class BasicMBPFormatter {
+    static_assert(Depth >= 1 && Depth <= MAX_BOOK_DEPTH, "unsupported MBP depth");
+
+public:
+    // Longest "price,size,count" level text: 24 + 1 + 11 + 1 + 11
+    static constexpr size_t LEVEL_TEXT_SIZE = 48;
+
+    // Room kept before the fields for the row index and its comma
+    static constexpr size_t INDEX_SPACE = 24;
+
+    // rtype column: 1 for MBP-1 and 10 for MBP-10. There is no deeper MBP
+    // record type, so deeper rows are tagged as MBP-10 and only their level
+    // count tells them apart
+    static constexpr int RTYPE = Depth == 1 ? 1 : 10;
+
+private:
+    struct LevelText {
+        char text[LEVEL_TEXT_SIZE];
+        uint8_t length;
+    };
+
+    LevelText bid_text[Depth];
+    LevelText ask_text[Depth];
+    bool primed = false;
+    std::vector<char> buffer;
+
+    TimestampCodec timestamps;
+
+    // Text of the last symbol id seen
+    uint32_t symbol_id = UINT32_MAX;
+    std::string symbol_text;
+
+    static void formatLevel(LevelText& out, const TopLevels& view, int index);
+
+public:
+    BasicMBPFormatter();
+
+    // Format one row terminated by '\n'; the view is valid until the next call
+    std::string_view formatRow(const MBORecord& record, long row_index, const OrderBook& book);
+
+    // Same row without the leading "index," for callers that number rows later
+    std::string_view formatFields(const MBORecord& record, const OrderBook& book);
+
+    // Force the next row to reformat every level
+    void invalidate() { primed = false; }
+};
+
+extern template class BasicMBPFormatter<1>;
+extern template class BasicMBPFormatter<BOOK_DEPTH>;
+extern template class BasicMBPFormatter<MAX_BOOK_DEPTH>;
+
+using MBPFormatter = BasicMBPFormatter<BOOK_DEPTH>;
+
+// Which records produce an MBP row
+enum class EmitMode {
+    AllRecords,   // one row per input record
+    BookChanges   // only records that change the visible top levels
+};
+
+// Whether the record just applied to book produces an MBP-Depth row. The
+// initial 'R' always does, like in the reference output.
+template <int Depth = BOOK_DEPTH>
+inline bool emitsRow(EmitMode mode, const MBORecord& record, const OrderBook& book) {
+    return mode == EmitMode::AllRecords || record.action == 'R' || book.lastChange().any(Depth);
+}
+
+// Write the MBP-N CSV header line for depth levels per side
+void writeMBPHeader(std::ostream& output, int depth = BOOK_DEPTH);
+
+// Integer to decimal text; return one past the last character written
+char* writeUnsigned(char* out, uint64_t value);
+char* writeSigned(char* out, int64_t value);
+
+#endif // MBP_FORMATTER_H
@@ -0,0 +1,44 @@
+#include "mbp_binary.h"
+#include "mbp_formatter.h"
+#include <fstream>
+#include <iostream>
+
+// Export a binary MBP-10 file (either layout) as the CSV the replay writes
+int main(int argc, char* argv[]) {
+    if (argc != 3) {
+        std::cerr << "Usage: " << argv[0] << " <input_mbp_file.bin> <output_mbp_file.csv>" << std::endl;
+        return 1;
+    }
+
+    MBPReader reader;
+    if (!reader.open(argv[1])) {
+        std::cerr << "Error: " << argv[1] << " is not a binary MBP-10 file" << std::endl;
+        return 1;
+    }
+
+    std::ofstream output(argv[2]);
+    if (!output.is_open()) {
+        std::cerr << "Error: Cannot create output file " << argv[2] << std::endl;
+        return 1;
+    }
+    writeMBPHeader(output);
+
+    PerformanceTimer timer("Export");
+    std::vector<char> buffer(MBP_ROW_MAX_SIZE);
+    BinaryMBPRecord record;
+    long row_index = 0;
+    while (reader.next(record)) {
+        const std::string& symbol = reader.symbol(record.symbol_id);
+        if (buffer.size() < MBP_ROW_MAX_SIZE + symbol.size()) {
+            buffer.resize(MBP_ROW_MAX_SIZE + symbol.size());
+        }
+        output.write(buffer.data(), formatMBPRecord(record, row_index++, symbol, buffer.data()));
+    }
+
+    if (reader.failed()) {
+        std::cerr << "Error: Corrupt data after row " << row_index << std::endl;
+        return 1;
+    }
+    std::cout << "Exported " << row_index << " rows to " << argv[2] << std::endl;
+    return 0;
+}
@@ -0,0 +1,216 @@
+#ifndef ORDER_TABLE_H
+#define ORDER_TABLE_H
+
+#include "orderbook_types.h"
+#include "latency_stats.h"
+#include <cstdint>
+#include <vector>
+
+// Flat Robin Hood hash table from order_id to pooled Order storage.
+//
+// Table slots are 16 bytes (key, pool index, probe distance), so a lookup
+// usually stays within the home cache line. Orders live in a contiguous pool
+// whose slots are recycled through a free list when orders are removed.
+// Deletion uses backward shifting, so there are no tombstones. Pointers
+// returned by find() are invalidated by the next insert().
+class OrderTable {
+public:
+    struct Stats {
+        size_t size = 0;
+        size_t capacity = 0;
+        double load_factor = 0.0;
+        double average_probe_length = 0.0;
+        uint32_t max_probe_length = 0;
+        size_t pool_capacity = 0;
+        size_t free_slots = 0;
+    };
+
+private:
+    struct Slot {
+        long order_id;
+        uint32_t pool_index;
+        uint32_t distance;  // probe distance + 1; 0 marks an empty slot
+    };
+
+    static constexpr uint32_t MAX_LOAD_NUM = 7;  // grow above 7/8 full
+    static constexpr uint32_t MAX_LOAD_DEN = 8;
+
+    std::vector<Slot> slots;
+    size_t mask = 0;
+    int shift = 64;
+    size_t count = 0;
+    std::vector<Order> pool;
+    std::vector<uint32_t> free_list;
+
+    size_t home(long order_id) const {
+        return static_cast<size_t>((static_cast<uint64_t>(order_id) * 0x9E3779B97F4A7C15ULL) >> shift);
+    }
+
+    // Slot position holding order_id, or slots.size() if absent
+    size_t locate(long order_id) const {
+        size_t pos = home(order_id);
+        for (uint32_t distance = 1;; ++distance) {
+            const Slot& slot = slots[pos];
+            if (slot.distance < distance) {  // empty or poorer slot
+                LATENCY_COUNT(HashProbes, distance);
+                return slots.size();
+            }
+            if (slot.order_id == order_id) {
+                LATENCY_COUNT(HashProbes, distance);
+                return pos;
+            }
+            pos = (pos + 1) & mask;
+        }
+    }
+
+    void place(Slot incoming) {
+        size_t pos = home(incoming.order_id);
+        incoming.distance = 1;
+        for (;;) {
+            Slot& slot = slots[pos];
+            if (slot.distance == 0) {
+                slot = incoming;
+                return;
+            }
+            if (slot.distance < incoming.distance) {
+                Slot displaced = slot;
+                slot = incoming;
+                incoming = displaced;
+            }
+            pos = (pos + 1) & mask;
+            incoming.distance++;
+        }
+    }
+
+    void resize(size_t capacity) {
+        std::vector<Slot> old;
+        old.swap(slots);
+        slots.assign(capacity, Slot{0, 0, 0});
+        mask = capacity - 1;
+        shift = 64 - __builtin_ctzll(capacity);
+        for (const Slot& slot : old) {
+            if (slot.distance != 0) place(slot);
+        }
+    }
+
+    void eraseAt(size_t pos) {
+        LATENCY_COUNT(OrdersRemoved, 1);
+        free_list.push_back(slots[pos].pool_index);
+        size_t next = (pos + 1) & mask;
+        while (slots[next].distance > 1) {
+            slots[pos] = slots[next];
+            slots[pos].distance--;
+            pos = next;
+            next = (next + 1) & mask;
+        }
+        slots[pos].distance = 0;
+        count--;
+    }
+
+public:
+    explicit OrderTable(size_t initial_capacity = 1024) {
+        size_t capacity = 16;
+        while (capacity < initial_capacity) capacity <<= 1;
+        resize(capacity);
+    }
+
+    Order* find(long order_id) {
+        size_t pos = locate(order_id);
+        return pos == slots.size() ? nullptr : &pool[slots[pos].pool_index];
+    }
+
+    const Order* find(long order_id) const {
+        size_t pos = locate(order_id);
+        return pos == slots.size() ? nullptr : &pool[slots[pos].pool_index];
+    }
+
+    // Insert or overwrite the order with order.order_id
+    Order& insert(const Order& order) {
+        if (Order* existing = find(order.order_id)) {
+            *existing = order;
+            return *existing;
+        }
+
+        if ((count + 1) * MAX_LOAD_DEN > slots.size() * MAX_LOAD_NUM) {
+            resize(slots.size() * 2);
+        }
+
+        uint32_t index;
+        if (!free_list.empty()) {
+            index = free_list.back();
+            free_list.pop_back();
+            pool[index] = order;
+        } else {
+            index = static_cast<uint32_t>(pool.size());
+            pool.push_back(order);
+        }
+
+        place(Slot{order.order_id, index, 0});
+        count++;
+        LATENCY_COUNT(OrdersAdded, 1);
+        return pool[index];
+    }
+
+    // Remove order_id, copying it to removed; false if absent. One probe.
+    bool remove(long order_id, Order& removed) {
+        size_t pos = locate(order_id);
+        if (pos == slots.size()) return false;
+        removed = pool[slots[pos].pool_index];
+        eraseAt(pos);
+        return true;
+    }
+
+    bool erase(long order_id) {
+        size_t pos = locate(order_id);
+        if (pos == slots.size()) return false;
+        eraseAt(pos);
+        return true;
+    }
+
+    // Room for n orders without growing the table or the pool
+    void reserve(size_t n) {
+        size_t capacity = slots.size();
+        while (n * MAX_LOAD_DEN > capacity * MAX_LOAD_NUM) capacity <<= 1;
+        if (capacity != slots.size()) resize(capacity);
+        pool.reserve(n);
+    }
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    size_t capacity() const { return slots.size(); }
+
+    void clear() {
+        for (Slot& slot : slots) slot.distance = 0;
+        count = 0;
+        pool.clear();
+        free_list.clear();
+    }
+
+    // Visit every live order
+    template <typename Visitor>
+    void forEach(Visitor visit) const {
+        for (const Slot& slot : slots) {
+            if (slot.distance != 0) visit(pool[slot.pool_index]);
+        }
+    }
+
+    Stats stats() const {
+        Stats s;
+        s.size = count;
+        s.capacity = slots.size();
+        s.load_factor = slots.empty() ? 0.0 : static_cast<double>(count) / slots.size();
+        s.pool_capacity = pool.size();
+        s.free_slots = free_list.size();
+
+        uint64_t total = 0;
+        for (const Slot& slot : slots) {
+            if (slot.distance == 0) continue;
+            total += slot.distance;
+            if (slot.distance > s.max_probe_length) s.max_probe_length = slot.distance;
+        }
+        s.average_probe_length = count ? static_cast<double>(total) / count : 0.0;
+        return s;
+    }
+};
+
+#endif // ORDER_TABLE_H
@@ -1,10 +1,39 @@
 #include "orderbook.h"
+#include "mbp_formatter.h"
 #include <algorithm>
 #include <cmath>
 
+size_t formatPrice(int64_t price, char* out) {
+    char* p = out;
+    uint64_t magnitude = static_cast<uint64_t>(price);
+    if (price < 0) {
+        *p++ = '-';
+        magnitude = 0 - magnitude;
+    }
+
+    // 1e-9 units -> hundredths, rounding half away from zero
+    uint64_t cents = (magnitude + PRICE_SCALE / 200) / (PRICE_SCALE / 100);
+    uint64_t whole = cents / 100;
+    unsigned fraction = static_cast<unsigned>(cents % 100);
+
+    char digits[20];
+    int n = 0;
+    do {
+        digits[n++] = static_cast<char>('0' + whole % 10);
+        whole /= 10;
+    } while (whole != 0);
+    while (n > 0) {
+        *p++ = digits[--n];
+    }
+
+    *p++ = '.';
+    *p++ = static_cast<char>('0' + fraction / 10);
+    *p++ = static_cast<char>('0' + fraction % 10);
+    return p - out;
+}
+
 // OrderBook Implementation
-OrderBook::OrderBook() {
-    orders.reserve(10000);  // Pre-allocate for performance
+OrderBook::OrderBook(int64_t tick_size) : bids(tick_size), asks(tick_size) {
 }
 
 OrderBook::~OrderBook() {
@@ -12,6 +41,10 @@ OrderBook::~OrderBook() {
 }
 
 void OrderBook::processRecord(const MBORecord& record) {
+    LATENCY_RECORD(record.action);
+    last_change = BookChange();
+    trades.tick();
+
     if (handleSpecialCases(record)) {
         return;
     }
@@ -24,11 +57,14 @@ void OrderBook::processRecord(const MBORecord& record) {
 }
 
 void OrderBook::handleRegularActions(const MBORecord& record) {
-    // Handle regular Add and Cancel actions
+    // Handle regular Add, Modify and Cancel actions
     switch (record.action) {
         case 'A':
             addOrder(record);
             break;
+        case 'M':
+            modifyOrder(record);
+            break;
         case 'C':
             cancelOrder(record);
             break;
@@ -41,7 +77,7 @@ void OrderBook::handleRegularActions(const MBORecord& record) {
 void OrderBook::addOrder(const MBORecord& record) {
     // Create order entry
     Order order(record.order_id, record.price, record.size, record.side);
-    orders[record.order_id] = order;
+    orders.insert(order);
 
     // Update price level
     if (record.side == 'B') {
@@ -51,152 +87,155 @@ void OrderBook::addOrder(const MBORecord& record) {
     }
 }
 
-void OrderBook::cancelOrder(const MBORecord& record) {
-    auto it = orders.find(record.order_id);
-    if (it != orders.end()) {
-        const Order& order = it->second;
+void OrderBook::modifyOrder(const MBORecord& record) {
+    // Single probe; the order is updated where it lives in the pool
+    Order* order = orders.find(record.order_id);
+    if (!order) {
+        // Order placed before the feed started: the modify is its first sight,
+        // unless it takes the order out of the book
+        if (record.size > 0) addOrder(record);
+        return;
+    }
+    if (record.size <= 0 || record.side != order->side) {
+        cancelOrder(record);
+        if (record.size > 0) addOrder(record);
+        return;
+    }
+
+    // Levels hold aggregates only, so the queue-priority change the MBO spec
+    // implies (kept for size decreases, lost for increases and price moves)
+    // has no effect on MBP output
+    int64_t old_price = order->price;
+    int old_size = order->size;
+    order->price = record.price;
+    order->size = record.size;
+
+    if (old_price == record.price) {
+        // Size change: adjust the level total in place
+        if (order->side == 'B') {
+            updatePriceLevel(bids, old_price, record.size - old_size, 0);
+        } else if (order->side == 'A') {
+            updatePriceLevel(asks, old_price, record.size - old_size, 0);
+        }
+    } else if (order->side == 'B') {
+        // Price change: move the order between levels
+        updatePriceLevel(bids, old_price, -old_size, -1);
+        updatePriceLevel(bids, record.price, record.size, 1);
+    } else if (order->side == 'A') {
+        updatePriceLevel(asks, old_price, -old_size, -1);
+        updatePriceLevel(asks, record.price, record.size, 1);
+    }
+}
 
+void OrderBook::cancelOrder(const MBORecord& record) {
+    // Single probe: remove from tracking and get the order back
+    Order order;
+    if (orders.remove(record.order_id, order)) {
         // Update price level (subtract the cancelled order)
         if (order.side == 'B') {
             updatePriceLevel(bids, order.price, -order.size, -1);
         } else if (order.side == 'A') {
             updatePriceLevel(asks, order.price, -order.size, -1);
         }
-
-        // Remove order from tracking
-        orders.erase(it);
     }
 }
 
-void OrderBook::handleTradeSequence(const std::vector<MBORecord>& sequence) {
-    if (sequence.size() != 3) return;
-
-    // const MBORecord& trade = sequence[0];  // Unused but kept for clarity
-    const MBORecord& fill = sequence[1];
-    // const MBORecord& cancel = sequence[2];  // Unused but kept for clarity
-
+void OrderBook::handleTradeSequence(const TradeSequenceTracker::Fill& fill) {
     // As per requirements: Trade appears on opposite side, but actual change is on the book side
-    // The Fill and Cancel actions show the actual side where the order exists
-    char actual_side = fill.side;  // This is where the order actually exists in the book
-
-    // Find and remove the filled order
-    auto it = orders.find(fill.order_id);
-    if (it != orders.end()) {
-        const Order& order = it->second;
-
+    // The Fill shows the actual side where the order exists
+    Order order;
+    if (orders.remove(fill.order_id, order)) {
         // Update price level (subtract the filled/cancelled order)
-        if (actual_side == 'B') {
+        if (fill.side == 'B') {
             updatePriceLevel(bids, order.price, -order.size, -1);
-        } else if (actual_side == 'A') {
+        } else if (fill.side == 'A') {
             updatePriceLevel(asks, order.price, -order.size, -1);
         }
-
-        // Remove order from tracking
-        orders.erase(it);
     }
 }
 
-std::vector<PriceLevel> OrderBook::getBidLevels(int max_levels) const {
-    std::vector<PriceLevel> result;
-    result.reserve(max_levels);
+void OrderBook::setViewDepth(int depth) {
+    view_depth = std::min(std::max(depth, 1), MAX_BOOK_DEPTH);
+    top_bids.count = bids.top(top_bids.levels, view_depth);
+    top_asks.count = asks.top(top_asks.levels, view_depth);
+}
 
-    // Bids are sorted in ascending order by map, but we want descending (highest first)
-    auto it = bids.rbegin();
-    for (int i = 0; i < max_levels && it != bids.rend(); ++it, ++i) {
-        result.push_back(it->second);
+std::vector<PriceLevel> OrderBook::getBidLevels(int max_levels) const {
+    if (max_levels <= view_depth) {
+        int n = std::min(std::max(max_levels, 0), top_bids.count);
+        return std::vector<PriceLevel>(top_bids.levels, top_bids.levels + n);
     }
 
+    // Deeper than the cached view: ladder scan yields bids highest first
+    std::vector<PriceLevel> result(max_levels);
+    result.resize(bids.top(result.data(), max_levels));
     return result;
 }
 
 std::vector<PriceLevel> OrderBook::getAskLevels(int max_levels) const {
-    std::vector<PriceLevel> result;
-    result.reserve(max_levels);
-
-    // Asks are sorted in ascending order (lowest first) - this is what we want
-    auto it = asks.begin();
-    for (int i = 0; i < max_levels && it != asks.end(); ++it, ++i) {
-        result.push_back(it->second);
+    if (max_levels <= view_depth) {
+        int n = std::min(std::max(max_levels, 0), top_asks.count);
+        return std::vector<PriceLevel>(top_asks.levels, top_asks.levels + n);
     }
 
+    // Deeper than the cached view: ladder scan yields asks lowest first
+    std::vector<PriceLevel> result(max_levels);
+    result.resize(asks.top(result.data(), max_levels));
     return result;
 }
 
 std::string OrderBook::generateMBPOutput(const MBORecord& record, int row_index) {
-    std::stringstream ss;
-
-    // Output the basic record information (columns 0-13)
-    ss << row_index << "," << record.ts_recv << ","
-       << record.ts_event << ","
-       << "10,"  // rtype for MBP
-       << record.publisher_id << ","
-       << record.instrument_id << ","
-       << record.action << ","
-       << record.side << ","
-       << "0,"   // depth
-       << std::fixed << std::setprecision(2) << record.price << ","
-       << record.size << ","
-       << record.flags << ","
-       << record.ts_in_delta << ","
-       << record.sequence << ",";
-
-    // Get current orderbook levels
-    auto bid_levels = getBidLevels(10);
-    auto ask_levels = getAskLevels(10);
-
-    // Output 10 levels of bid/ask data
-    for (int i = 0; i < 10; ++i) {
-        // Bid level
-        if (i < static_cast<int>(bid_levels.size())) {
-            ss << std::fixed << std::setprecision(2) << bid_levels[i].price << ","
-               << bid_levels[i].total_size << ","
-               << bid_levels[i].order_count << ",";
-        } else {
-            ss << ",0,0,";
-        }
-
-        // Ask level
-        if (i < static_cast<int>(ask_levels.size())) {
-            ss << std::fixed << std::setprecision(2) << ask_levels[i].price << ","
-               << ask_levels[i].total_size << ","
-               << ask_levels[i].order_count;
-        } else {
-            ss << ",0,0";
-        }
+    // One-off full-row format; streaming callers keep an MBPFormatter per book
+    MBPFormatter formatter;
+    std::string_view row = formatter.formatRow(record, row_index, *this);
+    return std::string(row.data(), row.size() - 1);  // without the trailing newline
+}
 
-        if (i < 9) ss << ",";
+void OrderBook::restoreOrder(const Order& order) {
+    orders.insert(order);
+    if (order.side == 'B') {
+        updatePriceLevel(bids, order.price, order.size, 1);
+    } else if (order.side == 'A') {
+        updatePriceLevel(asks, order.price, order.size, 1);
     }
+    last_change = BookChange();
+}
 
-    // Symbol and order_id
-    ss << "," << record.symbol << "," << record.order_id;
-
-    return ss.str();
+void OrderBook::restoreTradeSequences(const TradeSequenceTracker& state) {
+    trades = state;
 }
 
 void OrderBook::clear() {
     orders.clear();
     bids.clear();
     asks.clear();
-    pending_sequence.clear();
+    top_bids = TopLevels();
+    top_asks = TopLevels();
+    last_change = BookChange();
+    trades.clear();
 }
 
 void OrderBook::printBook() const {
     std::cout << "=== ORDERBOOK STATE ===\n";
+    OrderTable::Stats table = orders.stats();
     std::cout << "Orders tracked: " << orders.size() << "\n";
-    std::cout << "Bid levels: " << bids.size() << "\n";
-    std::cout << "Ask levels: " << asks.size() << "\n";
+    std::cout << "Order table: load " << std::fixed << std::setprecision(3) << table.load_factor
+              << ", avg probe " << table.average_probe_length
+              << ", max probe " << table.max_probe_length << std::defaultfloat << "\n";
+    std::cout << "Bid levels: " << bids.levelCount() << "\n";
+    std::cout << "Ask levels: " << asks.levelCount() << "\n";
 
     auto bid_levels = getBidLevels(5);
     auto ask_levels = getAskLevels(5);
 
     std::cout << "\nTop 5 Asks:\n";
     for (auto it = ask_levels.rbegin(); it != ask_levels.rend(); ++it) {
-        std::cout << "  " << it->price << " x " << it->total_size << " (" << it->order_count << " orders)\n";
+        std::cout << "  " << priceToDouble(it->price) << " x " << it->total_size << " (" << it->order_count << " orders)\n";
     }
 
     std::cout << "\nTop 5 Bids:\n";
     for (const auto& level : bid_levels) {
-        std::cout << "  " << level.price << " x " << level.total_size << " (" << level.order_count << " orders)\n";
+        std::cout << "  " << priceToDouble(level.price) << " x " << level.total_size << " (" << level.order_count << " orders)\n";
     }
     std::cout << "=======================\n\n";
 }
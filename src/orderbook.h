@@ -1,105 +1,143 @@
 #ifndef ORDERBOOK_H
 #define ORDERBOOK_H
 
-#include <unordered_map>
 #include <map>
 #include <vector>
 #include <string>
+#include <string_view>
 #include <iostream>
 #include <fstream>
 #include <sstream>
 #include <chrono>
 #include <iomanip>
+#include <cstdint>
 
-// Structure to represent a single MBO record
-struct MBORecord {
-    std::string ts_recv;
-    std::string ts_event;
-    int rtype;
-    int publisher_id;
-    int instrument_id;
-    char action;
-    char side;
-    double price;
-    int size;
-    int channel_id;
-    long order_id;
-    int flags;
-    int ts_in_delta;
-    long sequence;
-    std::string symbol;
-};
-
-// Structure to represent price level information
-struct PriceLevel {
-    double price;
-    int total_size;
-    int order_count;
-
-    PriceLevel() : price(0.0), total_size(0), order_count(0) {}
-    PriceLevel(double p, int s, int c) : price(p), total_size(s), order_count(c) {}
-};
-
-// Structure to represent an order in the book
-struct Order {
-    long order_id;
-    double price;
-    int size;
-    char side;
-
-    Order() : order_id(0), price(0.0), size(0), side('N') {}
-    Order(long id, double p, int s, char sd) : order_id(id), price(p), size(s), side(sd) {}
-};
+#include "orderbook_types.h"
+#include "price_ladder.h"
+#include "order_table.h"
+#include "trade_sequence.h"
 
 // High-performance orderbook class
 class OrderBook {
 private:
-    // Order tracking - Robin Hood hash map equivalent (unordered_map)
-    std::unordered_map<long, Order> orders;
+    // Order tracking - flat Robin Hood table over pooled Order storage
+    OrderTable orders;
 
-    // Price level tracking - using multimap for sorted price levels
-    std::map<double, PriceLevel> bids;  // Sorted descending (highest first)
-    std::map<double, PriceLevel> asks;  // Sorted ascending (lowest first)
+    // Price level tracking - dense tick-indexed ladders
+    PriceLadder<true> bids;   // Best (highest) first
+    PriceLadder<false> asks;  // Best (lowest) first
 
-    // Sequence tracking for T->F->C patterns
-    std::vector<MBORecord> pending_sequence;
+    // Incrementally maintained top-of-book views and the last change report
+    TopLevels top_bids;
+    TopLevels top_asks;
+    int view_depth = BOOK_DEPTH;
+    BookChange last_change;
+
+    // In-flight T->F->C sequences
+    TradeSequenceTracker trades;
 
 public:
-    OrderBook();
+    explicit OrderBook(int64_t tick_size = DEFAULT_TICK_SIZE);
     ~OrderBook();
 
     // Core functionality
     void processRecord(const MBORecord& record);
     void addOrder(const MBORecord& record);
+    void modifyOrder(const MBORecord& record);
     void cancelOrder(const MBORecord& record);
-    void handleTradeSequence(const std::vector<MBORecord>& sequence);
+    void handleTradeSequence(const TradeSequenceTracker::Fill& fill);
     void processBatch(const std::vector<MBORecord>& records);
 
     // Output generation
     std::string generateMBPOutput(const MBORecord& record, int row_index);
-    std::vector<PriceLevel> getBidLevels(int max_levels = 10) const;
-    std::vector<PriceLevel> getAskLevels(int max_levels = 10) const;
+    std::vector<PriceLevel> getBidLevels(int max_levels = BOOK_DEPTH) const;
+    std::vector<PriceLevel> getAskLevels(int max_levels = BOOK_DEPTH) const;
+
+    // Allocation-free reads of the cached top viewDepth() levels per side
+    const TopLevels& topBids() const { return top_bids; }
+    const TopLevels& topAsks() const { return top_asks; }
+
+    // Levels per side kept in the cached views (1 .. MAX_BOOK_DEPTH). A
+    // shallower view is cheaper to maintain; it must cover the deepest MBP
+    // output formatted from this book.
+    void setViewDepth(int depth);
+    int viewDepth() const { return view_depth; }
+
+    // View levels changed by the most recent processRecord call
+    const BookChange& lastChange() const { return last_change; }
+
+    // Trade sequences awaiting their fill or cancel
+    const TradeSequenceTracker& tradeSequences() const { return trades; }
+
+    // Checkpoint support: the resting orders are the whole book state besides
+    // the trade tracker; levels and views are rebuilt from them on restore
+    template <typename Visitor>
+    void forEachOrder(Visitor visit) const { orders.forEach(visit); }
+    void reserveOrders(size_t n) { orders.reserve(n); }
+    void restoreOrder(const Order& order);
+    void restoreTradeSequences(const TradeSequenceTracker& state);
+    void restoreLastChange(const BookChange& change) { last_change = change; }
 
     // Utility functions
+    OrderTable::Stats orderTableStats() const { return orders.stats(); }
     void clear();
     void printBook() const;
 
 private:
-    inline void updatePriceLevel(std::map<double, PriceLevel>& levels, double price, int size_delta, int count_delta) {
-        auto it = levels.find(price);
-        if (it != levels.end()) {
-            // Update existing level
-            PriceLevel& level = it->second;
-            level.total_size += size_delta;
-            level.order_count += count_delta;
-
-            // Remove level if no orders remain
-            if (level.order_count <= 0 || level.total_size <= 0) {
-                levels.erase(it);
+    template <typename Ladder>
+    inline void updatePriceLevel(Ladder& levels, int64_t price, int size_delta, int count_delta) {
+        // O(1) slot update; empty levels are removed by the ladder
+        levels.update(price, size_delta, count_delta);
+        LATENCY_SNAPSHOT();
+        if constexpr (Ladder::IS_BID) {
+            refreshTopLevels(top_bids, levels, price, view_depth, last_change.bid_mask);
+        } else {
+            refreshTopLevels(top_asks, levels, price, view_depth, last_change.ask_mask);
+        }
+    }
+
+    // Bring the cached view in line with the ladder after the level at price
+    // changed, marking the view indices that moved or changed
+    template <typename Ladder>
+    static void refreshTopLevels(TopLevels& view, const Ladder& levels, int64_t price, int depth, uint64_t& mask) {
+        auto better = [](int64_t a, int64_t b) { return Ladder::IS_BID ? a > b : a < b; };
+
+        int n = view.count;
+        int k = 0;
+        while (k < n && better(view.levels[k].price, price)) {
+            k++;
+        }
+
+        const PriceLevel* level = levels.find(price);
+        if (k < n && view.levels[k].price == price) {
+            if (level) {
+                // Level updated in place
+                view.levels[k] = *level;
+                mask |= 1ULL << k;
+                return;
             }
-        } else if (size_delta > 0 && count_delta > 0) {
-            // Add new level
-            levels.emplace(price, PriceLevel(price, size_delta, count_delta));
+
+            // Level removed: shift worse levels up and refill the last slot
+            for (int i = k; i < n - 1; ++i) {
+                view.levels[i] = view.levels[i + 1];
+            }
+            view.count = n - 1;
+            if (n == depth) {
+                int64_t last = n >= 2 ? view.levels[n - 2].price : price;
+                if (levels.nextWorse(last, view.levels[n - 1])) {
+                    view.count = n;
+                }
+            }
+            mask |= ((1ULL << n) - 1) & ~((1ULL << k) - 1);
+        } else if (level && k < depth) {
+            // New level inside the view: shift worse levels down
+            int count = n < depth ? n + 1 : depth;
+            for (int i = count - 1; i > k; --i) {
+                view.levels[i] = view.levels[i - 1];
+            }
+            view.levels[k] = *level;
+            view.count = count;
+            mask |= ((1ULL << count) - 1) & ~((1ULL << k) - 1);
         }
     }
 
@@ -113,36 +151,89 @@ private:
         return false;
     }
 
+    // T and F never change the book themselves; a C that completes a tracked
+    // sequence removes the filled order, any other C is a plain cancel
     inline bool detectSequence(const MBORecord& record) {
-        if (record.action == 'T' || record.action == 'F' || record.action == 'C') {
-            pending_sequence.push_back(record);
-            if (pending_sequence.size() >= 3) {
-                size_t start = pending_sequence.size() - 3;
-                if (pending_sequence[start].action == 'T' &&
-                    pending_sequence[start + 1].action == 'F' &&
-                    pending_sequence[start + 2].action == 'C') {
-                    handleTradeSequence({pending_sequence[start], pending_sequence[start + 1], pending_sequence[start + 2]});
-                    pending_sequence.clear();
+        switch (record.action) {
+            case 'T':
+                trades.onTrade(record);
+                return true;
+            case 'F':
+                trades.onFill(record);
+                return true;
+            case 'C': {
+                TradeSequenceTracker::Fill fill;
+                if (trades.onCancel(record, fill)) {
+                    LATENCY_RETAG(TradeCancel);
+                    handleTradeSequence(fill);
                     return true;
                 }
+                return false;
             }
+            default:
+                return false;
         }
-        return false;
     }
 
-    void removePriceLevel(std::map<double, PriceLevel>& levels, double price);
-    bool isTradeSequenceComplete() const;
-
     // Modularized helper functions
     void handleRegularActions(const MBORecord& record);
 };
 
+// Error codes reported by the non-throwing CSV parser and the binary reader
+enum class ParseError {
+    None = 0,
+    MissingFields,
+    BadInteger,
+    BadPrice,
+    LineTooLong,
+    BadTimestamp,
+    BadSymbol,
+    Count
+};
+
+const char* parseErrorName(ParseError error);
+
+// Per-file parse counters
+struct ParseStats {
+    size_t lines = 0;            // data lines seen (header and blank lines excluded)
+    size_t records = 0;          // lines parsed successfully
+    size_t errors = 0;           // malformed lines skipped
+    size_t by_error[static_cast<size_t>(ParseError::Count)] = {};
+    size_t first_error_line = 0; // 1-based file line of the first malformed line
+    ParseError first_error = ParseError::None;
+
+    void recordError(ParseError error, size_t line) {
+        errors++;
+        by_error[static_cast<size_t>(error)]++;
+        if (first_error == ParseError::None) {
+            first_error = error;
+            first_error_line = line;
+        }
+    }
+};
+
 // CSV parsing utilities
 class CSVParser {
 public:
-    static std::vector<MBORecord> parseFile(const std::string& filename);
+    // Records of a whole file in input order. With threads > 1 a CSV file is
+    // split into newline-aligned byte ranges parsed concurrently; the records
+    // and error reporting are the same as the serial path. stats, if given,
+    // receives the parse counters.
+    static std::vector<MBORecord> parseFile(const std::string& filename, int threads = 1,
+                                            ParseStats* stats = nullptr);
+
+    // parseFile from byte offset start, 0 or a value of MBOReader::position()
+    // (e.g. from a checkpoint). positions, if given, receives the offset just
+    // past each record. False if the file cannot be read from start.
+    static bool parseFileFrom(const std::string& filename, uint64_t start, std::vector<MBORecord>& records,
+                              std::vector<uint64_t>* positions = nullptr, int threads = 1,
+                              ParseStats* stats = nullptr);
     static MBORecord parseLine(const std::string& line);
     static std::vector<std::string> splitCSV(const std::string& line);
+
+    // Non-throwing parse into an existing record, interning the symbol; on error
+    // the record is left partly written
+    static ParseError parseLine(std::string_view line, MBORecord& record);
 };
 
 // Performance utilities
@@ -0,0 +1,103 @@
+#ifndef ORDERBOOK_TYPES_H
+#define ORDERBOOK_TYPES_H
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+// Prices are fixed-point integers in units of 1e-9, as in the source data
+constexpr int64_t PRICE_SCALE = 1000000000;
+
+inline double priceToDouble(int64_t price) {
+    return static_cast<double>(price) / PRICE_SCALE;
+}
+
+inline int64_t priceFromDouble(double price) {
+    return static_cast<int64_t>(price * PRICE_SCALE + (price < 0 ? -0.5 : 0.5));
+}
+
+// Write price as decimal text with two fractional digits (rounded half away
+// from zero); returns the number of characters written (at most 24)
+size_t formatPrice(int64_t price, char* out);
+
+// Structure to represent a single MBO record.
+//
+// Trivially copyable and 64 bytes: the fields the book reads come first,
+// routing keys next, and output-only fields last. Timestamps are nanoseconds
+// since the epoch and symbol_id indexes SymbolTable::global().
+struct MBORecord {
+    int64_t price;
+    long order_id;
+    int size;
+    char action;
+    char side;
+    uint16_t publisher_id;
+    uint32_t instrument_id;
+    uint32_t symbol_id;
+    int64_t ts_recv;
+    int64_t ts_event;
+    uint32_t sequence;
+    int32_t ts_in_delta;
+    uint16_t channel_id;
+    uint8_t rtype;
+    uint8_t flags;
+};
+
+static_assert(sizeof(MBORecord) == 64, "MBORecord should stay one cache line");
+static_assert(std::is_trivially_copyable<MBORecord>::value, "MBORecord should be trivially copyable");
+
+// Structure to represent price level information
+struct PriceLevel {
+    int64_t price;
+    int total_size;
+    int order_count;
+
+    PriceLevel() : price(0), total_size(0), order_count(0) {}
+    PriceLevel(int64_t p, int s, int c) : price(p), total_size(s), order_count(c) {}
+};
+
+// Default MBP depth and number of levels per side in a book's cached view
+constexpr int BOOK_DEPTH = 10;
+
+// Deepest view a book can cache (MBP-50); change masks hold one bit per level
+constexpr int MAX_BOOK_DEPTH = 50;
+static_assert(MAX_BOOK_DEPTH < 64, "BookChange masks need a bit per level");
+
+// Bits for view indices 0 .. depth-1
+constexpr uint64_t levelMask(int depth) { return (1ULL << depth) - 1; }
+
+// Cached best-first view of one side's top levels, up to the book's view depth
+struct TopLevels {
+    PriceLevel levels[MAX_BOOK_DEPTH];
+    int count = 0;
+};
+
+// Level indices of the cached views changed by the last processed record
+// (bit i set: level i changed, was inserted, or shifted)
+struct BookChange {
+    uint64_t bid_mask = 0;
+    uint64_t ask_mask = 0;
+
+    // Whether any of the first depth levels changed
+    bool any(int depth = MAX_BOOK_DEPTH) const { return ((bid_mask | ask_mask) & levelMask(depth)) != 0; }
+
+    // First of the first depth view indices that changed (the MBP depth
+    // column); 0 when none did
+    int depth(int depth = MAX_BOOK_DEPTH) const {
+        uint64_t mask = (bid_mask | ask_mask) & levelMask(depth);
+        return mask ? __builtin_ctzll(mask) : 0;
+    }
+};
+
+// Structure to represent an order in the book
+struct Order {
+    long order_id;
+    int64_t price;
+    int size;
+    char side;
+
+    Order() : order_id(0), price(0), size(0), side('N') {}
+    Order(long id, int64_t p, int s, char sd) : order_id(id), price(p), size(s), side(sd) {}
+};
+
+#endif // ORDERBOOK_TYPES_H
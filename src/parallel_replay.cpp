@@ -0,0 +1,189 @@
+#include "parallel_replay.h"
+
+// ParallelReplay Implementation
+ParallelReplay::ParallelReplay(int threads, size_t batch_records, EmitMode mode)
+    : batch_size(batch_records > 0 ? batch_records : DEFAULT_BATCH_SIZE), emit_mode(mode) {
+    size_t count = threads > 0 ? static_cast<size_t>(threads) : 1;
+    for (Batch& batch : batches) {
+        batch.records.resize(batch_size);
+    }
+    rows.resize(batch_size);
+    row_shard.resize(batch_size);
+
+    for (size_t i = 0; i < count; ++i) {
+        workers.push_back(std::make_unique<Worker>());
+    }
+    for (size_t i = 0; i < count; ++i) {
+        workers[i]->thread = std::thread(&ParallelReplay::workerLoop, this, i);
+    }
+}
+
+ParallelReplay::~ParallelReplay() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    start_cv.notify_all();
+    for (auto& worker : workers) {
+        if (worker->thread.joinable()) {
+            worker->thread.join();
+        }
+    }
+}
+
+size_t ParallelReplay::shardOf(const MBORecord& record) const {
+    uint64_t key = (static_cast<uint64_t>(static_cast<uint32_t>(record.publisher_id)) << 32) |
+                   static_cast<uint32_t>(record.instrument_id);
+    return static_cast<size_t>(((key * 0x9E3779B97F4A7C15ULL) >> 32) % workers.size());
+}
+
+size_t ParallelReplay::fill(MBOReader& reader, Batch& batch) {
+    batch.count = 0;
+    while (batch.count < batch_size && reader.next(batch.records[batch.count])) {
+        batch.count++;
+    }
+    return batch.count;
+}
+
+void ParallelReplay::assign(const Batch& batch) {
+    for (auto& worker : workers) {
+        worker->indices.clear();
+    }
+    for (size_t i = 0; i < batch.count; ++i) {
+        size_t shard = shardOf(batch.records[i]);
+        row_shard[i] = static_cast<uint16_t>(shard);
+        workers[shard]->indices.push_back(static_cast<uint32_t>(i));
+    }
+}
+
+void ParallelReplay::processShard(Worker& worker, const Batch& batch) {
+    worker.arena.clear();
+    for (uint32_t i : worker.indices) {
+        const MBORecord& record = batch.records[i];
+        BookEntry& entry = worker.books.route(record);
+        entry.book.processRecord(record);
+        if (!emitsRow(emit_mode, record, entry.book)) {
+            rows[i] = RowRef{0, 0};
+            continue;
+        }
+        std::string_view row = entry.formatter.formatFields(record, entry.book);
+
+        rows[i] = RowRef{static_cast<uint32_t>(worker.arena.size()), static_cast<uint32_t>(row.size())};
+        worker.arena.insert(worker.arena.end(), row.begin(), row.end());
+    }
+}
+
+// Numbered rows of the batch positions in this worker's slice, in input order
+void ParallelReplay::mergeSlice(size_t shard, const Batch& batch) {
+    Worker& worker = *workers[shard];
+    size_t begin = batch.count * shard / workers.size();
+    size_t end = batch.count * (shard + 1) / workers.size();
+    size_t written = worker.first_row;
+    char index[24];
+    worker.output.clear();
+    for (size_t i = begin; i < end; ++i) {
+        const RowRef& row = rows[i];
+        if (row.length == 0) continue;
+        char* index_end = writeUnsigned(index, written++);
+        *index_end++ = ',';
+        worker.output.insert(worker.output.end(), index, index_end);
+        const char* text = workers[row_shard[i]]->arena.data() + row.offset;
+        worker.output.insert(worker.output.end(), text, text + row.length);
+    }
+}
+
+void ParallelReplay::workerLoop(size_t shard) {
+    uint64_t seen = 0;
+    Worker& worker = *workers[shard];
+    for (;;) {
+        const Batch* batch;
+        Phase current;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            start_cv.wait(lock, [&] { return stopping || generation != seen; });
+            if (stopping) {
+                return;
+            }
+            seen = generation;
+            batch = active;
+            current = phase;
+        }
+
+        if (current == Phase::Apply) {
+            processShard(worker, *batch);
+        } else {
+            mergeSlice(shard, *batch);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--pending == 0) {
+                done_cv.notify_one();
+            }
+        }
+    }
+}
+
+void ParallelReplay::start(const Batch& batch, Phase next) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        active = &batch;
+        phase = next;
+        pending = workers.size();
+        generation++;
+    }
+    start_cv.notify_all();
+}
+
+void ParallelReplay::waitDone() {
+    std::unique_lock<std::mutex> lock(mutex);
+    done_cv.wait(lock, [&] { return pending == 0; });
+}
+
+template <typename Append>
+size_t ParallelReplay::replay(MBOReader& reader, Append append) {
+    size_t written = 0;
+    records_read = 0;
+    int current = 0;
+    fill(reader, batches[current]);
+
+    while (batches[current].count > 0) {
+        Batch& batch = batches[current];
+        assign(batch);
+        start(batch, Phase::Apply);
+
+        // Read ahead while the workers apply this batch
+        fill(reader, batches[1 - current]);
+        waitDone();
+
+        // Each slice's rows are numbered from the rows before it
+        for (size_t shard = 0; shard < workers.size(); ++shard) {
+            size_t begin = batch.count * shard / workers.size();
+            size_t end = batch.count * (shard + 1) / workers.size();
+            workers[shard]->first_row = written;
+            for (size_t i = begin; i < end; ++i) {
+                written += rows[i].length != 0;
+            }
+        }
+        start(batch, Phase::Merge);
+        waitDone();
+
+        for (auto& worker : workers) {
+            append(worker->output.data(), worker->output.size());
+        }
+        records_read += batch.count;
+        current = 1 - current;
+    }
+
+    return written;
+}
+
+size_t ParallelReplay::run(MBOReader& reader, std::ostream& output) {
+    return replay(reader, [&](const char* data, size_t length) {
+        output.write(data, static_cast<std::streamsize>(length));
+    });
+}
+
+size_t ParallelReplay::run(MBOReader& reader, AsyncWriter& output) {
+    return replay(reader, [&](const char* data, size_t length) { output.append(data, length); });
+}
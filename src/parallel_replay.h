@@ -0,0 +1,109 @@
+#ifndef PARALLEL_REPLAY_H
+#define PARALLEL_REPLAY_H
+
+#include "async_writer.h"
+#include "book_manager.h"
+#include "mbo_reader.h"
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <thread>
+#include <vector>
+
+// Multi-threaded replay sharded by instrument.
+//
+// The calling thread reads records in batches and assigns each record to a
+// worker by hashing its (publisher_id, instrument_id). Every worker owns a
+// BookManager, so books are never shared and need no locks. Workers format
+// their rows into private arenas. Once a batch is applied, the workers also
+// merge it: each copies the rows of one contiguous slice of the batch, in
+// input order, into its own output buffer, and the calling thread appends
+// the buffers in slice order. The output is byte-identical to the
+// single-threaded replay. Reading the next batch overlaps with the workers
+// applying the current one. Rows are numbered during the merge, so with
+// EmitMode::BookChanges the index stays consecutive.
+//
+// Reading and parsing stay on the calling thread, so they bound the speedup.
+class ParallelReplay {
+public:
+    static constexpr size_t DEFAULT_BATCH_SIZE = 1 << 16;
+
+private:
+    struct Batch {
+        std::vector<MBORecord> records;
+        size_t count = 0;
+    };
+
+    struct RowRef {
+        uint32_t offset;
+        uint32_t length;  // 0: record produced no row
+    };
+
+    // What the workers do with the active batch
+    enum class Phase {
+        Apply,  // process their records and format rows into the arenas
+        Merge   // copy the rows of their slice into output
+    };
+
+    struct Worker {
+        BookManager books;
+        std::vector<uint32_t> indices;  // positions in the current batch
+        std::vector<char> arena;        // formatted rows of the current batch
+        std::vector<char> output;       // numbered rows of this worker's slice
+        size_t first_row = 0;           // row index of the slice's first row
+        std::thread thread;
+    };
+
+    size_t batch_size;
+    EmitMode emit_mode;
+    size_t records_read = 0;
+    std::vector<std::unique_ptr<Worker>> workers;
+    Batch batches[2];
+    std::vector<RowRef> rows;
+    std::vector<uint16_t> row_shard;
+
+    // Batch hand-off between the calling thread and the workers
+    std::mutex mutex;
+    std::condition_variable start_cv;
+    std::condition_variable done_cv;
+    uint64_t generation = 0;
+    size_t pending = 0;
+    bool stopping = false;
+    const Batch* active = nullptr;
+    Phase phase = Phase::Apply;
+
+    size_t shardOf(const MBORecord& record) const;
+    size_t fill(MBOReader& reader, Batch& batch);
+    void assign(const Batch& batch);
+    void start(const Batch& batch, Phase next);
+    void waitDone();
+    void workerLoop(size_t shard);
+    void processShard(Worker& worker, const Batch& batch);
+    void mergeSlice(size_t shard, const Batch& batch);
+
+    // run() with append(data, length) receiving the output in order
+    template <typename Append>
+    size_t replay(MBOReader& reader, Append append);
+
+public:
+    explicit ParallelReplay(int threads, size_t batch_records = DEFAULT_BATCH_SIZE,
+                            EmitMode mode = EmitMode::AllRecords);
+    ~ParallelReplay();
+
+    ParallelReplay(const ParallelReplay&) = delete;
+    ParallelReplay& operator=(const ParallelReplay&) = delete;
+
+    // Replay every record from reader, writing MBP rows to output in input
+    // order; returns the number of rows written
+    size_t run(MBOReader& reader, std::ostream& output);
+    size_t run(MBOReader& reader, AsyncWriter& output);
+
+    // Records replayed by the last run()
+    size_t recordsRead() const { return records_read; }
+
+    size_t shardCount() const { return workers.size(); }
+    const BookManager& shard(size_t index) const { return workers[index]->books; }
+};
+
+#endif // PARALLEL_REPLAY_H
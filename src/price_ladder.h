@@ -0,0 +1,363 @@
+#ifndef PRICE_LADDER_H
+#define PRICE_LADDER_H
+
+#include "orderbook_types.h"
+#include "latency_stats.h"
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+// Default tick: 0.01 in 1e-9 price units
+constexpr int64_t DEFAULT_TICK_SIZE = PRICE_SCALE / 100;
+
+// Dense tick-indexed price levels for one side of the book.
+//
+// Levels on the tick grid within `window` ticks of a moving anchor live in a
+// contiguous array indexed by tick offset, with a two-level occupancy bitmap
+// (one bit per slot, one summary bit per 64-slot word) so the best level and
+// the next ones are found with bit scans. Levels off the grid or outside the
+// window spill into an overflow array sorted from worst to best. Updates
+// inside the window are O(1) and allocation-free.
+//
+// The slot array is allocated on the first level and starts at MIN_WINDOW
+// slots; a new level outside it doubles the window, up to WINDOW, until the
+// level fits. A file of thousands of thin books thus costs about 1 KB per
+// side instead of WINDOW slots. A new best outside the window, or the best
+// overflow level once the array empties, re-centers the window on itself,
+// doubling it the same way so that the levels behind it stay dense. Apart
+// from off-grid prices, only levels over WINDOW / 2 ticks behind the best
+// spill. Re-centering
+// shifts the slots and bitmaps in place; once the window has grown, moving
+// the best costs no allocation.
+template <bool IsBid>
+class PriceLadder {
+public:
+    static constexpr bool IS_BID = IsBid;
+    static constexpr int WINDOW = 4096;
+    static constexpr int MIN_WINDOW = 64;
+    static constexpr int WORDS = WINDOW / 64;
+    static_assert(WORDS <= 64, "summary bitmap holds one bit per word");
+    static constexpr size_t OVERFLOW_RESERVE = 32;  // levels, on the first spill
+
+private:
+    int64_t tick;
+    int64_t anchor = 0;        // price of slot 0, a multiple of tick
+    bool anchored = false;
+    int window = MIN_WINDOW;   // slots in use once anchored, MIN_WINDOW .. WINDOW
+    std::vector<PriceLevel> slots;
+    uint64_t occupancy[WORDS] = {};
+    uint64_t summary = 0;
+    int dense_count = 0;
+    std::vector<PriceLevel> overflow;  // worst first, so the best is at the back
+
+    static bool better(int64_t a, int64_t b) { return IsBid ? a > b : a < b; }
+
+    // Position of the first overflow level not worse than price
+    size_t overflowAt(int64_t price) const {
+        auto it = std::lower_bound(overflow.begin(), overflow.end(), price,
+                                   [](const PriceLevel& level, int64_t p) { return better(p, level.price); });
+        return static_cast<size_t>(it - overflow.begin());
+    }
+
+    bool inOverflow(int64_t price) const {
+        size_t at = overflowAt(price);
+        return at < overflow.size() && overflow[at].price == price;
+    }
+
+    // Window doubled from the current size, up to WINDOW, until a level
+    // `ticks` behind the center fits
+    int grownWindow(int64_t ticks) const {
+        int new_window = window;
+        while (new_window < WINDOW && ticks >= new_window / 2) new_window *= 2;
+        return new_window;
+    }
+
+    int64_t ticksBetween(int64_t a, int64_t b) const { return (a > b ? a - b : b - a) / tick; }
+
+    int slotIndex(int64_t price) const {
+        if (!anchored || price < anchor) return -1;
+        int64_t offset = price - anchor;
+        if (offset % tick != 0 || offset / tick >= window) return -1;
+        return static_cast<int>(offset / tick);
+    }
+
+    bool occupied(int index) const {
+        return (occupancy[index >> 6] >> (index & 63)) & 1;
+    }
+
+    void setBit(int index) {
+        int word = index >> 6;
+        occupancy[word] |= 1ULL << (index & 63);
+        summary |= 1ULL << word;
+        dense_count++;
+    }
+
+    void clearBit(int index) {
+        int word = index >> 6;
+        occupancy[word] &= ~(1ULL << (index & 63));
+        if (occupancy[word] == 0) summary &= ~(1ULL << word);
+        dense_count--;
+    }
+
+    // Best occupied slot at `from` or worse, or -1
+    int scanFrom(int from) const {
+        int word = from >> 6;
+        int bit = from & 63;
+        if (IsBid) {
+            uint64_t bits = occupancy[word] & (bit == 63 ? ~0ULL : ((1ULL << (bit + 1)) - 1));
+            if (bits) return (word << 6) + 63 - __builtin_clzll(bits);
+            uint64_t words = summary & ((1ULL << word) - 1);
+            if (!words) return -1;
+            word = 63 - __builtin_clzll(words);
+            return (word << 6) + 63 - __builtin_clzll(occupancy[word]);
+        } else {
+            uint64_t bits = occupancy[word] & (~0ULL << bit);
+            if (bits) return (word << 6) + __builtin_ctzll(bits);
+            uint64_t words = word == 63 ? 0 : summary & (~0ULL << (word + 1));
+            if (!words) return -1;
+            word = __builtin_ctzll(words);
+            return (word << 6) + __builtin_ctzll(occupancy[word]);
+        }
+    }
+
+    int bestSlot() const {
+        return dense_count == 0 ? -1 : scanFrom(IsBid ? window - 1 : 0);
+    }
+
+    int worstSlot() const {
+        if (dense_count == 0) return -1;
+        if (IsBid) {
+            int word = __builtin_ctzll(summary);
+            return (word << 6) + __builtin_ctzll(occupancy[word]);
+        }
+        int word = 63 - __builtin_clzll(summary);
+        return (word << 6) + 63 - __builtin_clzll(occupancy[word]);
+    }
+
+    int nextSlot(int index) const {
+        if (IsBid) return index == 0 ? -1 : scanFrom(index - 1);
+        return index == window - 1 ? -1 : scanFrom(index + 1);
+    }
+
+    void applyOverflow(int64_t price, int size_delta, int count_delta) {
+        size_t at = overflowAt(price);
+        if (at < overflow.size() && overflow[at].price == price) {
+            PriceLevel& level = overflow[at];
+            level.total_size += size_delta;
+            level.order_count += count_delta;
+            if (level.order_count <= 0 || level.total_size <= 0) {
+                overflow.erase(overflow.begin() + at);
+                LATENCY_COUNT(LevelsRemoved, 1);
+            }
+        } else if (size_delta > 0 && count_delta > 0) {
+            if (overflow.capacity() == 0) overflow.reserve(OVERFLOW_RESERVE);
+            overflow.insert(overflow.begin() + at, PriceLevel(price, size_delta, count_delta));
+            LATENCY_COUNT(LevelsAdded, 1);
+        }
+    }
+
+    // Move the window so `price` sits in the middle of new_window (>= window)
+    // slots. Dense levels left outside are merged into the overflow array, the
+    // rest shift to their new slots, and overflow levels now inside move into
+    // the array.
+    void recenter(int64_t price, int new_window) {
+        int64_t aligned = price - ((price % tick) + tick) % tick;
+        int64_t new_anchor = aligned - (new_window / 2) * tick;
+        int64_t shift = anchored ? (new_anchor - anchor) / tick : 0;
+        auto leaves = [&](int index) { return index < shift || index - shift >= new_window; };
+
+        // Spilled levels go best first into the tail of the overflow array,
+        // which is merged from the back
+        int spilled = 0;
+        for (int index = bestSlot(); index >= 0; index = nextSlot(index)) {
+            spilled += leaves(index);
+        }
+        if (spilled > 0) {
+            size_t kept = overflow.size();
+            if (overflow.capacity() == 0) overflow.reserve(std::max<size_t>(OVERFLOW_RESERVE, spilled));
+            overflow.resize(kept + spilled);
+            size_t out = overflow.size();
+            for (int index = bestSlot(); index >= 0; index = nextSlot(index)) {
+                if (!leaves(index)) continue;
+                while (kept > 0 && better(overflow[kept - 1].price, slots[index].price)) {
+                    overflow[--out] = overflow[--kept];
+                }
+                overflow[--out] = slots[index];
+                clearBit(index);
+            }
+        }
+
+        if (slots.size() < static_cast<size_t>(new_window)) slots.resize(new_window);
+
+        // Shift the remaining levels, walking away from the side they move to
+        // so that no level is overwritten before it has moved
+        if (shift != 0 && dense_count > 0) {
+            uint64_t shifted[WORDS] = {};
+            auto move = [&](int index) {
+                int target = static_cast<int>(index - shift);
+                slots[target] = slots[index];
+                shifted[target >> 6] |= 1ULL << (target & 63);
+            };
+            if (shift > 0) {
+                for (int word = 0; word < WORDS; ++word) {
+                    for (uint64_t bits = occupancy[word]; bits; bits &= bits - 1) {
+                        move((word << 6) + __builtin_ctzll(bits));
+                    }
+                }
+            } else {
+                for (int word = WORDS - 1; word >= 0; --word) {
+                    for (uint64_t bits = occupancy[word]; bits; ) {
+                        int bit = 63 - __builtin_clzll(bits);
+                        move((word << 6) + bit);
+                        bits &= ~(1ULL << bit);
+                    }
+                }
+            }
+            summary = 0;
+            for (int word = 0; word < WORDS; ++word) {
+                occupancy[word] = shifted[word];
+                if (shifted[word]) summary |= 1ULL << word;
+            }
+        }
+
+        anchor = new_anchor;
+        anchored = true;
+        window = new_window;
+
+        // Pull in the overflow levels the window now covers, compacting the rest
+        size_t kept = 0;
+        for (size_t i = 0; i < overflow.size(); ++i) {
+            int index = slotIndex(overflow[i].price);
+            if (index >= 0) {
+                slots[index] = overflow[i];
+                setBit(index);
+            } else {
+                overflow[kept++] = overflow[i];
+            }
+        }
+        overflow.resize(kept);
+    }
+
+public:
+    explicit PriceLadder(int64_t tick_size = DEFAULT_TICK_SIZE)
+        : tick(tick_size > 0 ? tick_size : 1) {}
+
+    // Apply a size/count delta to the level at price. A level is created only
+    // by a positive delta and removed once its size or count reaches zero.
+    void update(int64_t price, int size_delta, int count_delta) {
+        int index = slotIndex(price);
+        if (index < 0 && size_delta > 0 && count_delta > 0 && price % tick == 0 && !inOverflow(price)) {
+            int best = bestSlot();
+            if (best < 0 || better(price, slots[best].price)) {
+                // Center on the new best, growing so the levels behind it stay dense
+                int worst = worstSlot();
+                recenter(price, worst < 0 ? window : grownWindow(ticksBetween(price, slots[worst].price)));
+                index = slotIndex(price);
+            } else if (window < WINDOW) {
+                // Grow around the best level until the new one fits
+                int64_t best_price = slots[best].price;
+                recenter(best_price, grownWindow(ticksBetween(price, best_price)));
+                index = slotIndex(price);
+            }
+        }
+
+        if (index < 0) {
+            applyOverflow(price, size_delta, count_delta);
+            return;
+        }
+
+        if (occupied(index)) {
+            PriceLevel& level = slots[index];
+            level.total_size += size_delta;
+            level.order_count += count_delta;
+            if (level.order_count <= 0 || level.total_size <= 0) {
+                clearBit(index);
+                LATENCY_COUNT(LevelsRemoved, 1);
+                if (dense_count == 0 && !overflow.empty()) {
+                    // Center on the best overflow level, growing to take in the rest
+                    int64_t best_price = overflow.back().price;
+                    recenter(best_price, grownWindow(ticksBetween(best_price, overflow.front().price)));
+                }
+            }
+        } else if (size_delta > 0 && count_delta > 0) {
+            slots[index] = PriceLevel(price, size_delta, count_delta);
+            setBit(index);
+            LATENCY_COUNT(LevelsAdded, 1);
+        }
+    }
+
+    // Level at price, or nullptr if there is none
+    const PriceLevel* find(int64_t price) const {
+        int index = slotIndex(price);
+        if (index >= 0) return occupied(index) ? &slots[index] : nullptr;
+        size_t at = overflowAt(price);
+        return at < overflow.size() && overflow[at].price == price ? &overflow[at] : nullptr;
+    }
+
+    // Best level strictly worse than price; false if there is none
+    bool nextWorse(int64_t price, PriceLevel& out) const {
+        int index = -1;
+        if (dense_count > 0) {
+            int64_t offset = price - anchor;
+            if (IsBid) {
+                if (offset > 0) {
+                    int64_t from = (offset - 1) / tick;
+                    index = scanFrom(from >= window ? window - 1 : static_cast<int>(from));
+                }
+            } else {
+                int64_t from = offset < 0 ? 0 : offset / tick + 1;
+                if (from < window) index = scanFrom(static_cast<int>(from));
+            }
+        }
+
+        // Overflow levels before overflowAt(price) are strictly worse
+        size_t at = overflowAt(price);
+        const PriceLevel* spill = at > 0 ? &overflow[at - 1] : nullptr;
+
+        if (index >= 0 && (!spill || better(slots[index].price, spill->price))) {
+            out = slots[index];
+            return true;
+        }
+        if (spill) {
+            out = *spill;
+            return true;
+        }
+        return false;
+    }
+
+    // Copy up to max_levels levels, best first; returns the number copied
+    int top(PriceLevel* out, int max_levels) const {
+        int n = 0;
+        int index = bestSlot();
+        auto it = overflow.rbegin();
+        auto last = overflow.rend();
+        while (n < max_levels) {
+            bool have_dense = index >= 0;
+            bool have_overflow = it != last;
+            if (have_dense && (!have_overflow || better(slots[index].price, it->price))) {
+                out[n++] = slots[index];
+                index = nextSlot(index);
+            } else if (have_overflow) {
+                out[n++] = *it;
+                ++it;
+            } else {
+                break;
+            }
+        }
+        return n;
+    }
+
+    size_t levelCount() const { return dense_count + overflow.size(); }
+    size_t overflowCount() const { return overflow.size(); }
+    int64_t tickSize() const { return tick; }
+
+    void clear() {
+        for (int word = 0; word < WORDS; ++word) occupancy[word] = 0;
+        summary = 0;
+        dense_count = 0;
+        anchored = false;
+        overflow.clear();
+    }
+};
+
+#endif // PRICE_LADDER_H
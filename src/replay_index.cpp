@@ -0,0 +1,166 @@
+#include "replay_index.h"
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <sys/stat.h>
+
+namespace {
+
+bool fileSize(const std::string& filename, uint64_t& size) {
+    struct stat st;
+    if (stat(filename.c_str(), &st) != 0) {
+        return false;
+    }
+    size = static_cast<uint64_t>(st.st_size);
+    return true;
+}
+
+// Apply record and remember it as its book's last
+void applyRecord(BookManager& books, std::vector<IndexedBookState>& last, const MBORecord& record,
+                 uint64_t record_index) {
+    BookEntry& entry = books.route(record);
+    entry.book.processRecord(record);
+    if (entry.index >= last.size()) {
+        last.resize(entry.index + 1);
+    }
+    last[entry.index] = IndexedBookState{record, record_index, entry.book.lastChange()};
+}
+
+} // namespace
+
+bool buildReplayIndex(const std::string& input_file, const std::string& index_file, const IndexOptions& options,
+                      uint64_t* records, uint32_t* snapshots) {
+    MBOReader reader;
+    ReplayIndexHeader header{};
+    if (!reader.open(input_file) || !fileSize(input_file, header.input_size)) {
+        return false;
+    }
+    std::ofstream out(index_file, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+        return false;
+    }
+
+    // Placeholder header, rewritten once the table is written
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    BookManager books;
+    std::vector<IndexedBookState> last;
+    std::vector<ReplayIndexEntry> entries;
+    uint64_t count = 0;
+    int64_t max_ts_event = INT64_MIN;
+    int64_t snapshot_time = INT64_MIN;
+
+    auto snapshot = [&]() {
+        ReplayIndexEntry entry;
+        entry.ts_event = max_ts_event;
+        entry.records = count;
+        entry.input_offset = reader.position();
+        entry.snapshot_offset = static_cast<uint64_t>(out.tellp());
+        entries.push_back(entry);
+
+        CheckpointPosition position;
+        position.records = count;
+        position.input_offset = entry.input_offset;
+        writeCheckpoint(out, books, position);
+        out.write(reinterpret_cast<const char*>(last.data()), last.size() * sizeof(IndexedBookState));
+        snapshot_time = max_ts_event;
+    };
+
+    // The empty book before the first record, so every query has a snapshot
+    snapshot();
+
+    MBORecord record;
+    while (reader.next(record)) {
+        applyRecord(books, last, record, count);
+        count++;
+        max_ts_event = std::max(max_ts_event, record.ts_event);
+        if (snapshot_time == INT64_MIN) {
+            snapshot_time = max_ts_event;
+        }
+
+        bool due = (options.every_records > 0 && count - entries.back().records >= options.every_records) ||
+                   (options.every_ns > 0 && max_ts_event - snapshot_time >= options.every_ns);
+        if (due) {
+            snapshot();
+        }
+    }
+
+    std::memcpy(header.magic, REPLAY_INDEX_MAGIC, sizeof(header.magic));
+    header.version = REPLAY_INDEX_VERSION;
+    header.snapshot_count = static_cast<uint32_t>(entries.size());
+    header.table_offset = static_cast<uint64_t>(out.tellp());
+    header.records = count;
+    out.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(ReplayIndexEntry));
+    out.seekp(0);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.close();
+
+    if (records) *records = count;
+    if (snapshots) *snapshots = header.snapshot_count;
+    return static_cast<bool>(out);
+}
+
+// ReplayIndex Implementation
+bool ReplayIndex::open(const std::string& index_file, const std::string& input_file) {
+    index.close();
+    index.clear();
+    entries.clear();
+
+    index.open(index_file, std::ios::binary);
+    ReplayIndexHeader header;
+    uint64_t input_size = 0;
+    if (!index.is_open() || !index.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        std::memcmp(header.magic, REPLAY_INDEX_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != REPLAY_INDEX_VERSION || header.snapshot_count == 0 ||
+        !fileSize(input_file, input_size) || input_size != header.input_size) {
+        return false;
+    }
+
+    entries.resize(header.snapshot_count);
+    index.seekg(static_cast<std::streamoff>(header.table_offset));
+    if (!index.read(reinterpret_cast<char*>(entries.data()), entries.size() * sizeof(ReplayIndexEntry))) {
+        entries.clear();
+        return false;
+    }
+    record_count = header.records;
+    return reader.open(input_file);
+}
+
+bool ReplayIndex::query(int64_t ts_event, BookManager& books, std::vector<IndexedBookState>& last) {
+    if (entries.empty()) {
+        return false;
+    }
+
+    // Latest snapshot whose records all precede the first one after ts_event;
+    // the first entry (ts_event INT64_MIN) always qualifies
+    auto after = std::upper_bound(entries.begin(), entries.end(), ts_event,
+                                  [](int64_t t, const ReplayIndexEntry& entry) { return t < entry.ts_event; });
+    const ReplayIndexEntry& entry = *(after - 1);
+
+    index.clear();
+    index.seekg(static_cast<std::streamoff>(entry.snapshot_offset));
+    CheckpointPosition position;
+    if (!readCheckpoint(index, books, position)) {
+        return false;
+    }
+    last.assign(books.size(), IndexedBookState{});
+    if (!index.read(reinterpret_cast<char*>(last.data()), last.size() * sizeof(IndexedBookState))) {
+        return false;
+    }
+    // Symbol ids are per process: take the restored book's
+    for (BookEntry& book : books) {
+        last[book.index].record.symbol_id = book.symbol_id;
+        book.book.restoreLastChange(last[book.index].change);
+    }
+
+    if (!reader.seek(entry.input_offset)) {
+        return false;
+    }
+    MBORecord record;
+    uint64_t record_index = entry.records;
+    while (reader.next(record) && record.ts_event <= ts_event) {
+        applyRecord(books, last, record, record_index++);
+    }
+    last_gap = record_index - entry.records;
+    return true;
+}
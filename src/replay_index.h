@@ -0,0 +1,90 @@
+#ifndef REPLAY_INDEX_H
+#define REPLAY_INDEX_H
+
+#include "checkpoint.h"
+#include "mbo_reader.h"
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Seekable index of an MBO input for point-in-time book queries.
+//
+// The build pass replays the input once and stores a book snapshot (in the
+// checkpoint format) every every_records records and every every_ns of
+// ts_event, each tagged with the input byte offset of the next record. A
+// query loads the nearest snapshot before the requested time and replays
+// only the records after it, so its cost is bounded by the snapshot interval
+// rather than the position in the day.
+//
+// "The book at time t" is the state after every record before the first one
+// whose ts_event is later than t. ts_event is not strictly ordered in the
+// feed, so snapshots are keyed by the largest ts_event applied so far.
+//
+// Layout: a 64-byte ReplayIndexHeader, the snapshots, then snapshot_count
+// ReplayIndexEntries at table_offset. Each snapshot is a checkpoint followed
+// by one IndexedBookState per book, so queries can print the same MBP-10
+// rows as a full replay.
+constexpr char REPLAY_INDEX_MAGIC[8] = {'M', 'B', 'O', 'I', 'D', 'X', '\0', '\0'};
+constexpr uint32_t REPLAY_INDEX_VERSION = 1;
+
+struct ReplayIndexHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t snapshot_count;
+    uint64_t table_offset;
+    uint64_t input_size;  // size of the indexed file, to catch a different input
+    uint64_t records;     // records in the input
+    uint8_t reserved[24];
+};
+
+struct ReplayIndexEntry {
+    int64_t ts_event;          // largest ts_event applied before the snapshot
+    uint64_t records;          // records applied
+    uint64_t input_offset;     // MBOReader::position() of the next record
+    uint64_t snapshot_offset;  // byte offset of the snapshot in the index
+};
+
+static_assert(sizeof(ReplayIndexHeader) == 64, "replay index header must be 64 bytes");
+static_assert(sizeof(ReplayIndexEntry) == 32, "replay index entry must be 32 bytes");
+
+// Last record applied to a book, with what it changed
+struct IndexedBookState {
+    MBORecord record;
+    uint64_t record_index;  // 0-based position in the input (the MBP row index)
+    BookChange change;
+};
+
+struct IndexOptions {
+    uint64_t every_records = 100000;
+    int64_t every_ns = 0;  // 0: by record count only
+};
+
+// Replay input_file and write its index; records and snapshots, if given,
+// receive the counts
+bool buildReplayIndex(const std::string& input_file, const std::string& index_file, const IndexOptions& options,
+                      uint64_t* records = nullptr, uint32_t* snapshots = nullptr);
+
+// Answers point-in-time queries from an index and its memory-mapped input
+class ReplayIndex {
+private:
+    std::ifstream index;
+    std::vector<ReplayIndexEntry> entries;
+    MBOReader reader;
+    uint64_t record_count = 0;
+    uint64_t last_gap = 0;
+
+public:
+    bool open(const std::string& index_file, const std::string& input_file);
+
+    // Replace books with the book at time ts_event (ns since the epoch);
+    // last receives each book's IndexedBookState by BookEntry::index
+    bool query(int64_t ts_event, BookManager& books, std::vector<IndexedBookState>& last);
+
+    // Records replayed after the snapshot by the last query
+    uint64_t lastGap() const { return last_gap; }
+    size_t snapshotCount() const { return entries.size(); }
+    uint64_t records() const { return record_count; }
+};
+
+#endif // REPLAY_INDEX_H
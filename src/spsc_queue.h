@@ -0,0 +1,159 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <thread>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+// Bounded lock-free single-producer/single-consumer ring.
+//
+// One thread calls tryPush, one other thread calls tryPop. Head and tail
+// live on separate cache lines, and each side keeps a cached copy of the
+// other's index so the shared line is only read when the ring looks full
+// or empty.
+template <typename T>
+class SpscQueue {
+private:
+    static constexpr size_t CACHE_LINE = 64;
+
+    std::unique_ptr<T[]> slots;
+    size_t mask;
+
+    alignas(CACHE_LINE) std::atomic<size_t> tail{0};  // written by the producer
+    size_t cached_head = 0;
+    alignas(CACHE_LINE) std::atomic<size_t> head{0};  // written by the consumer
+    size_t cached_tail = 0;
+
+public:
+    // capacity is rounded up to a power of two
+    explicit SpscQueue(size_t capacity) {
+        size_t size = 1;
+        while (size < capacity) size <<= 1;
+        slots.reset(new T[size]);
+        mask = size - 1;
+    }
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    bool tryPush(const T& value) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if (t - cached_head > mask) {
+            cached_head = head.load(std::memory_order_acquire);
+            if (t - cached_head > mask) {
+                return false;
+            }
+        }
+        slots[t & mask] = value;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool tryPop(T& value) {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h == cached_tail) {
+            cached_tail = tail.load(std::memory_order_acquire);
+            if (h == cached_tail) {
+                return false;
+            }
+        }
+        value = slots[h & mask];
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    size_t capacity() const { return mask + 1; }
+};
+
+// Wait step for a side that found the ring full or empty: spin briefly, then
+// yield, then sleep. Cheap when the other side is about to respond, without
+// burning a core when it is not. Reset attempts once the ring moves.
+inline void backoff(unsigned& attempts) {
+    if (++attempts < 64) {
+        return;
+    }
+    if (attempts < 256) {
+        std::this_thread::yield();
+    } else {
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+}
+
+// Wait step for a consumer that must react as soon as an item lands: spin
+// with a CPU pause hint, then yield, and never sleep. It holds a core while
+// the ring is empty, which is the price of latency bounded by a spin loop
+// rather than a timer. Reset attempts once the ring moves.
+inline void spinWait(unsigned& attempts) {
+    if (++attempts < 64) {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#elif defined(__aarch64__)
+        __asm__ __volatile__("yield");
+#endif
+        return;
+    }
+    std::this_thread::yield();
+}
+
+// Lets the idle side of a ring block on an eventfd instead of polling it.
+//
+// The idle side spins first (spinWait) and then calls park() with a check
+// for the condition it waits on; the other side calls wake() after each
+// push. wake() costs a fence and a load unless the idle side is parked,
+// and the fences guarantee that either park() sees the push or wake() sees
+// the parked flag, so no wake-up is lost.
+class RingWaiter {
+private:
+    int fd = -1;
+    std::atomic<bool> parked{false};
+
+public:
+    RingWaiter() = default;
+    ~RingWaiter() { close(); }
+
+    RingWaiter(const RingWaiter&) = delete;
+    RingWaiter& operator=(const RingWaiter&) = delete;
+
+    bool open() {
+        close();
+        fd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        parked = false;
+        return fd >= 0;
+    }
+
+    void close() {
+        if (fd >= 0) ::close(fd);
+        fd = -1;
+    }
+
+    // Block until woken or timeout_ms (-1: no timeout) unless ready() already holds
+    template <typename Ready>
+    void park(Ready ready, int timeout_ms = -1) {
+        parked.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!ready()) {
+            pollfd request{fd, POLLIN, 0};
+            ::poll(&request, 1, timeout_ms);
+            uint64_t count;
+            ssize_t drained = ::read(fd, &count, sizeof(count));
+            (void)drained;  // nothing to drain after a timeout
+        }
+        parked.store(false, std::memory_order_relaxed);
+    }
+
+    void wake() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (parked.load(std::memory_order_relaxed)) {
+            uint64_t one = 1;
+            ssize_t written = ::write(fd, &one, sizeof(one));
+            (void)written;  // a full counter already wakes the reader of it
+        }
+    }
+};
+
+#endif // SPSC_QUEUE_H
@@ -0,0 +1,57 @@
+#ifndef SYMBOL_TABLE_H
+#define SYMBOL_TABLE_H
+
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+// Interned symbol strings: each distinct symbol is stored once and referred
+// to by a dense 32-bit id. Safe to use from several threads; names live in a
+// deque, so references returned by name() stay valid while others intern.
+class SymbolTable {
+private:
+    std::deque<std::string> names;
+    std::unordered_map<std::string_view, uint32_t> ids;  // views into names
+    mutable std::mutex mutex;
+
+public:
+    uint32_t intern(std::string_view symbol) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = ids.find(symbol);
+        if (it != ids.end()) {
+            return it->second;
+        }
+        uint32_t id = static_cast<uint32_t>(names.size());
+        names.emplace_back(symbol);
+        ids.emplace(names.back(), id);
+        return id;
+    }
+
+    const std::string& name(uint32_t id) const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return names[id];
+    }
+
+    size_t size() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return names.size();
+    }
+
+    // For local tables only: records keep ids of the global one
+    void clear() {
+        std::lock_guard<std::mutex> lock(mutex);
+        ids.clear();
+        names.clear();
+    }
+
+    // Process-wide table that MBORecord::symbol_id refers to
+    static SymbolTable& global() {
+        static SymbolTable table;
+        return table;
+    }
+};
+
+#endif // SYMBOL_TABLE_H
@@ -0,0 +1,243 @@
+#include "timestamp.h"
+#include <cstring>
+
+#if defined(__SSSE3__)
+#include <immintrin.h>
+#endif
+
+namespace {
+
+constexpr int64_t NS_PER_SECOND = 1000000000;
+constexpr int64_t SECONDS_PER_DAY = 86400;
+
+// Days since 1970-01-01 of a proleptic Gregorian date
+int64_t daysFromCivil(int64_t year, unsigned month, unsigned day) {
+    year -= month <= 2;
+    int64_t era = (year >= 0 ? year : year - 399) / 400;
+    unsigned year_of_era = static_cast<unsigned>(year - era * 400);
+    unsigned day_of_year = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+    unsigned day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+    return era * 146097 + static_cast<int64_t>(day_of_era) - 719468;
+}
+
+void civilFromDays(int64_t days, int64_t& year, unsigned& month, unsigned& day) {
+    days += 719468;
+    int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+    unsigned day_of_era = static_cast<unsigned>(days - era * 146097);
+    unsigned year_of_era = (day_of_era - day_of_era / 1460 + day_of_era / 36524 - day_of_era / 146096) / 365;
+    unsigned day_of_year = day_of_era - (365 * year_of_era + year_of_era / 4 - year_of_era / 100);
+    unsigned mp = (5 * day_of_year + 2) / 153;
+    day = day_of_year - (153 * mp + 2) / 5 + 1;
+    month = mp < 10 ? mp + 3 : mp - 9;
+    year = static_cast<int64_t>(year_of_era) + era * 400 + (month <= 2);
+}
+
+inline bool parseDigits(const char* p, int count, unsigned& value) {
+    value = 0;
+    for (int i = 0; i < count; ++i) {
+        unsigned digit = static_cast<unsigned>(p[i] - '0');
+        if (digit > 9) return false;
+        value = value * 10 + digit;
+    }
+    return true;
+}
+
+inline void writeDigits(char* out, unsigned value, int count) {
+    for (int i = count - 1; i >= 0; --i) {
+        out[i] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    }
+}
+
+// Seconds into the hour and nanoseconds of "MM:SS.fffffffffZ"
+inline bool parseTail(const char* p, int64_t& second_of_hour, int64_t& fraction) {
+#if defined(__SSSE3__)
+    const __m128i text = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    const __m128i digits = _mm_sub_epi8(text, _mm_set1_epi8('0'));
+
+    // Every digit position holds 0-9 and the separators are in place
+    const __m128i digit_positions = _mm_setr_epi8(-1, -1, 0, -1, -1, 0, -1, -1, -1, -1, -1, -1, -1, -1, -1, 0);
+    const __m128i separators = _mm_setr_epi8(0, 0, ':', 0, 0, '.', 0, 0, 0, 0, 0, 0, 0, 0, 0, 'Z');
+    __m128i is_digit = _mm_cmpeq_epi8(_mm_max_epu8(digits, _mm_set1_epi8(9)), _mm_set1_epi8(9));
+    __m128i valid = _mm_or_si128(_mm_and_si128(is_digit, digit_positions), _mm_cmpeq_epi8(text, separators));
+    if (_mm_movemask_epi8(valid) != 0xFFFF) {
+        return false;
+    }
+
+    // Gather digit pairs: MM, SS, f0f1, f2f3, f4f5, f6f7, 0f8, 00
+    const __m128i order = _mm_setr_epi8(0, 1, 3, 4, 6, 7, 8, 9, 10, 11, 12, 13, -1, 14, -1, -1);
+    __m128i pairs = _mm_maddubs_epi16(_mm_shuffle_epi8(digits, order), _mm_setr_epi8(10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1));
+    int minute = _mm_extract_epi16(pairs, 0);
+    int second = _mm_extract_epi16(pairs, 1);
+    if (minute > 59 || second > 60) {
+        return false;
+    }
+
+    // 32-bit lanes: MM*60+SS, f0-f3, f4-f7, f8
+    __m128i quads = _mm_madd_epi16(pairs, _mm_setr_epi16(60, 1, 100, 1, 100, 1, 1, 0));
+    second_of_hour = _mm_cvtsi128_si32(quads);
+    fraction = static_cast<int64_t>(_mm_cvtsi128_si32(_mm_srli_si128(quads, 4))) * 100000 +
+               _mm_cvtsi128_si32(_mm_srli_si128(quads, 8)) * 10 + _mm_cvtsi128_si32(_mm_srli_si128(quads, 12));
+    return true;
+#else
+    unsigned minute, second, high, low;
+    if (p[2] != ':' || p[5] != '.' || p[15] != 'Z' || !parseDigits(p, 2, minute) || !parseDigits(p + 3, 2, second) ||
+        !parseDigits(p + 6, 5, high) || !parseDigits(p + 11, 4, low) || minute > 59 || second > 60) {
+        return false;
+    }
+    second_of_hour = minute * 60 + second;
+    fraction = static_cast<int64_t>(high) * 10000 + low;
+    return true;
+#endif
+}
+
+// Eight decimal digits of value (< 1e8) as ASCII, most significant first, in
+// one 64-bit word: four pairs are split off and each pair into two digits
+// in parallel lanes
+inline uint64_t eightDigits(uint32_t value) {
+    uint64_t x = value / 10000 | static_cast<uint64_t>(value % 10000) << 32;
+    uint64_t hundreds = ((x * 10486) >> 20) & 0x0000007F0000007FULL;
+    uint64_t pairs = hundreds | (x - hundreds * 100) << 16;
+    uint64_t tens = ((pairs * 103) >> 10) & 0x000F000F000F000FULL;
+    uint64_t digits = tens | (pairs - tens * 10) << 8;
+    return digits + 0x3030303030303030ULL;
+}
+
+} // namespace
+
+bool parseTimestamp(std::string_view text, int64_t& ns) {
+    // Shortest form: "YYYY-MM-DDTHH:MM:SSZ"
+    if (text.size() < 20 || text.size() > TIMESTAMP_LENGTH || text.back() != 'Z') {
+        return false;
+    }
+    const char* p = text.data();
+    if (p[4] != '-' || p[7] != '-' || p[10] != 'T' || p[13] != ':' || p[16] != ':') {
+        return false;
+    }
+
+    unsigned year, month, day, hour, minute, second;
+    if (!parseDigits(p, 4, year) || !parseDigits(p + 5, 2, month) || !parseDigits(p + 8, 2, day) ||
+        !parseDigits(p + 11, 2, hour) || !parseDigits(p + 14, 2, minute) || !parseDigits(p + 17, 2, second)) {
+        return false;
+    }
+    if (month < 1 || month > 12 || day < 1 || day > 31 || hour > 23 || minute > 59 || second > 60) {
+        return false;
+    }
+
+    // Optional fraction, scaled to nanoseconds
+    unsigned fraction = 0;
+    size_t fraction_digits = 0;
+    if (text.size() > 20) {
+        fraction_digits = text.size() - 21;
+        if (p[19] != '.' || fraction_digits == 0 ||
+            !parseDigits(p + 20, static_cast<int>(fraction_digits), fraction)) {
+            return false;
+        }
+        for (size_t i = fraction_digits; i < 9; ++i) {
+            fraction *= 10;
+        }
+    }
+
+    int64_t days = daysFromCivil(year, month, day);
+    int64_t seconds = days * SECONDS_PER_DAY + hour * 3600 + minute * 60 + second;
+    ns = seconds * NS_PER_SECOND + fraction;
+    return true;
+}
+
+size_t formatTimestamp(int64_t ns, char* out) {
+    int64_t seconds = ns / NS_PER_SECOND;
+    int64_t fraction = ns % NS_PER_SECOND;
+    if (fraction < 0) {
+        fraction += NS_PER_SECOND;
+        seconds--;
+    }
+    int64_t days = seconds / SECONDS_PER_DAY;
+    int64_t second_of_day = seconds % SECONDS_PER_DAY;
+    if (second_of_day < 0) {
+        second_of_day += SECONDS_PER_DAY;
+        days--;
+    }
+
+    int64_t year;
+    unsigned month, day;
+    civilFromDays(days, year, month, day);
+
+    writeDigits(out, static_cast<unsigned>(year), 4);
+    out[4] = '-';
+    writeDigits(out + 5, month, 2);
+    out[7] = '-';
+    writeDigits(out + 8, day, 2);
+    out[10] = 'T';
+    writeDigits(out + 11, static_cast<unsigned>(second_of_day / 3600), 2);
+    out[13] = ':';
+    writeDigits(out + 14, static_cast<unsigned>(second_of_day / 60 % 60), 2);
+    out[16] = ':';
+    writeDigits(out + 17, static_cast<unsigned>(second_of_day % 60), 2);
+    out[19] = '.';
+    writeDigits(out + 20, static_cast<unsigned>(fraction), 9);
+    out[29] = 'Z';
+    return TIMESTAMP_LENGTH;
+}
+
+// TimestampCodec Implementation
+bool TimestampCodec::parse(std::string_view text, int64_t& ns) {
+    if (text.size() != TIMESTAMP_LENGTH) {
+        return parseTimestamp(text, ns);
+    }
+
+    const char* p = text.data();
+    Prefix prefix;
+    std::memcpy(&prefix.head, p, sizeof(prefix.head));
+    std::memcpy(&prefix.tail, p + PREFIX_LENGTH - sizeof(prefix.tail), sizeof(prefix.tail));
+    if (!parse_cached || prefix.head != parse_prefix.head || prefix.tail != parse_prefix.tail) {
+        // New hour: parse "YYYY-MM-DDTHH:00:00Z" through the general path
+        char hour_text[20];
+        std::memcpy(hour_text, p, PREFIX_LENGTH);
+        std::memcpy(hour_text + PREFIX_LENGTH, "00:00Z", 6);
+        if (!parseTimestamp(std::string_view(hour_text, sizeof(hour_text)), parse_hour)) {
+            return false;
+        }
+        parse_prefix = prefix;
+        parse_cached = true;
+    }
+
+    int64_t second_of_hour, fraction;
+    if (!parseTail(p + PREFIX_LENGTH, second_of_hour, fraction)) {
+        return false;
+    }
+    ns = parse_hour + second_of_hour * NS_PER_SECOND + fraction;
+    return true;
+}
+
+size_t TimestampCodec::format(int64_t ns, char* out) {
+    if (!format_cached || static_cast<uint64_t>(ns - format_hour) >= static_cast<uint64_t>(NS_PER_HOUR)) {
+        // New hour: format its start through the general path
+        format_hour = ns - ((ns % NS_PER_HOUR) + NS_PER_HOUR) % NS_PER_HOUR;
+        char hour_text[TIMESTAMP_LENGTH];
+        formatTimestamp(format_hour, hour_text);
+        std::memcpy(&format_prefix.head, hour_text, sizeof(format_prefix.head));
+        std::memcpy(&format_prefix.tail, hour_text + PREFIX_LENGTH - sizeof(format_prefix.tail), sizeof(format_prefix.tail));
+        format_cached = true;
+    }
+
+    uint64_t offset = static_cast<uint64_t>(ns - format_hour);
+    uint32_t second_of_hour = static_cast<uint32_t>(offset / NS_PER_SECOND);
+    uint32_t fraction = static_cast<uint32_t>(offset - static_cast<uint64_t>(second_of_hour) * NS_PER_SECOND);
+    uint32_t minute = second_of_hour / 60;
+    uint32_t second = second_of_hour - minute * 60;
+
+    std::memcpy(out, &format_prefix.head, sizeof(format_prefix.head));
+    std::memcpy(out + PREFIX_LENGTH - sizeof(format_prefix.tail), &format_prefix.tail, sizeof(format_prefix.tail));
+    char* p = out + PREFIX_LENGTH;
+    p[0] = static_cast<char>('0' + minute / 10);
+    p[1] = static_cast<char>('0' + minute % 10);
+    p[2] = ':';
+    p[3] = static_cast<char>('0' + second / 10);
+    p[4] = static_cast<char>('0' + second % 10);
+    p[5] = '.';
+    p[6] = static_cast<char>('0' + fraction / 100000000);
+    uint64_t digits = eightDigits(fraction % 100000000);
+    std::memcpy(p + 7, &digits, sizeof(digits));
+    p[15] = 'Z';
+    return TIMESTAMP_LENGTH;
+}
@@ -0,0 +1,49 @@
+#ifndef TIMESTAMP_H
+#define TIMESTAMP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// ISO-8601 UTC timestamps as in the source data, e.g.
+// "2025-07-17T08:05:03.360677248Z", held as nanoseconds since the Unix epoch
+constexpr size_t TIMESTAMP_LENGTH = 30;
+
+// Parse "YYYY-MM-DDTHH:MM:SS[.f...]Z" with 0-9 fractional digits
+bool parseTimestamp(std::string_view text, int64_t& ns);
+
+// Write ns with nine fractional digits; returns TIMESTAMP_LENGTH
+size_t formatTimestamp(int64_t ns, char* out);
+
+// Stateful codec for streams of timestamps. Consecutive records nearly always
+// share the date and hour, so the "YYYY-MM-DDTHH:" prefix and its epoch offset
+// are cached and only "MM:SS.fffffffffZ" is converted per call: with SSSE3 in
+// one 16-byte vector, otherwise with scalar code. Other forms fall back to
+// parseTimestamp. Keep one codec per thread.
+class TimestampCodec {
+private:
+    static constexpr size_t PREFIX_LENGTH = 14;  // "YYYY-MM-DDTHH:"
+    static constexpr int64_t NS_PER_HOUR = 3600LL * 1000000000LL;
+
+    // Prefix text as two overlapping 8-byte words (bytes 0-7 and 6-13)
+    struct Prefix {
+        uint64_t head = 0;
+        uint64_t tail = 0;
+    };
+
+    // Parse cache
+    Prefix parse_prefix;
+    int64_t parse_hour = 0;
+    bool parse_cached = false;
+
+    // Format cache
+    Prefix format_prefix;
+    int64_t format_hour = 0;
+    bool format_cached = false;
+
+public:
+    bool parse(std::string_view text, int64_t& ns);
+    size_t format(int64_t ns, char* out);
+};
+
+#endif // TIMESTAMP_H
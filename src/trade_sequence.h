@@ -0,0 +1,136 @@
+#ifndef TRADE_SEQUENCE_H
+#define TRADE_SEQUENCE_H
+
+#include "orderbook_types.h"
+#include <cstdint>
+
+// Fixed-capacity state machine for in-flight T -> F -> C trade sequences.
+//
+// A trade (T) waits for the fill (F) with the same sequence number; the fill
+// names the resting order, and the sequence then waits for that order's
+// cancel (C). Any number of sequences up to CAPACITY can be in flight and
+// interleave, e.g. an aggressor sweeping several levels at the open
+// (T T F F C C). Fills match waiting trades oldest first. Entries live in an
+// inline array, so tracking never allocates; entries not completed within
+// EXPIRY_RECORDS records of the book are dropped, and a full tracker evicts
+// its oldest entry.
+class TradeSequenceTracker {
+public:
+    static constexpr int CAPACITY = 32;
+    static constexpr uint32_t EXPIRY_RECORDS = 1024;
+
+    // The resting order taken by a completed sequence
+    struct Fill {
+        long order_id;
+        int64_t price;
+        int size;
+        char side;
+    };
+
+private:
+    enum class State : uint8_t { Empty, AwaitFill, AwaitCancel };
+
+    struct Entry {
+        long order_id;      // resting order, once the fill is seen
+        int64_t price;
+        uint32_t sequence;
+        uint32_t started;   // clock value when the trade was seen
+        int size;
+        char side;
+        State state = State::Empty;
+    };
+
+    Entry entries[CAPACITY];
+    uint32_t clock = 0;
+    int active = 0;
+    uint64_t expired_count = 0;
+
+    // Wrap-safe clock order
+    static bool older(uint32_t a, uint32_t b) { return static_cast<int32_t>(a - b) < 0; }
+
+    // Free slot, evicting the oldest entry when none is left
+    Entry& allocate() {
+        Entry* oldest = nullptr;
+        for (Entry& entry : entries) {
+            if (entry.state == State::Empty) return entry;
+            if (!oldest || older(entry.started, oldest->started)) oldest = &entry;
+        }
+        release(*oldest);
+        expired_count++;
+        return *oldest;
+    }
+
+    void release(Entry& entry) {
+        entry.state = State::Empty;
+        active--;
+    }
+
+    void expire() {
+        for (Entry& entry : entries) {
+            if (entry.state != State::Empty && clock - entry.started > EXPIRY_RECORDS) {
+                release(entry);
+                expired_count++;
+            }
+        }
+    }
+
+public:
+    // Advance the clock by one book record; stale entries are swept now and then
+    void tick() {
+        clock++;
+        if (active > 0 && (clock & 63) == 0) {
+            expire();
+        }
+    }
+
+    void onTrade(const MBORecord& trade) {
+        Entry& entry = allocate();
+        entry.order_id = 0;
+        entry.sequence = trade.sequence;
+        entry.started = clock;
+        entry.state = State::AwaitFill;
+        active++;
+    }
+
+    // Attach the fill to the oldest trade with its sequence number; false if none waits
+    bool onFill(const MBORecord& fill) {
+        Entry* match = nullptr;
+        for (Entry& entry : entries) {
+            if (entry.state == State::AwaitFill && entry.sequence == fill.sequence &&
+                (!match || older(entry.started, match->started))) {
+                match = &entry;
+            }
+        }
+        if (!match) return false;
+        match->order_id = fill.order_id;
+        match->price = fill.price;
+        match->size = fill.size;
+        match->side = fill.side;
+        match->state = State::AwaitCancel;
+        return true;
+    }
+
+    // Complete the sequence whose fill took cancel's order; false for a plain cancel
+    bool onCancel(const MBORecord& cancel, Fill& out) {
+        for (Entry& entry : entries) {
+            if (entry.state == State::AwaitCancel && entry.order_id == cancel.order_id) {
+                out = Fill{entry.order_id, entry.price, entry.size, entry.side};
+                release(entry);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    int inFlight() const { return active; }
+    uint64_t expired() const { return expired_count; }
+
+    void clear() {
+        for (Entry& entry : entries) entry.state = State::Empty;
+        active = 0;
+        clock = 0;
+        expired_count = 0;
+    }
+};
+
+#endif // TRADE_SEQUENCE_H
@@ -0,0 +1,454 @@
+#include "orderbook.h"
+#include "mbp_formatter.h"
+#include "symbol_table.h"
+#include "timestamp.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Allocation counting: every operator new in this binary goes through here.
+// GCC pairs the inlined malloc/free with new/delete and warns; they match.
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+static std::atomic<uint64_t> allocation_count{0};
+
+void* operator new(size_t size) {
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size) {
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t) noexcept { std::free(p); }
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Operations prepared by one untimed setup call; each is timed on its own
+constexpr int BATCH = 8;
+
+struct Result {
+    std::string name;
+    std::map<std::string, int> params;
+    double ns_per_op = 0;
+    double p50 = 0;
+    double p99 = 0;
+    double p999 = 0;
+    double allocs_per_op = 0;
+
+    std::string id() const {
+        std::string text = name;
+        for (const auto& param : params) {
+            text += "/" + param.first + "=" + std::to_string(param.second);
+        }
+        return text;
+    }
+};
+
+uint64_t rng_state = 12345;
+uint64_t nextRandom() {
+    rng_state = rng_state * 6364136223846793005ULL + 1442695040888963407ULL;
+    return rng_state >> 33;
+}
+
+// Median of an empty timed interval: what a start/end pair of clock reads
+// adds to every single-operation latency
+double clockOverhead() {
+    const int rounds = 100001;
+    std::vector<double> intervals(rounds);
+    for (int i = 0; i < rounds; ++i) {
+        auto start = Clock::now();
+        asm volatile("" : : : "memory");
+        auto end = Clock::now();
+        intervals[i] = std::chrono::duration<double, std::nano>(end - start).count();
+    }
+    std::nth_element(intervals.begin(), intervals.begin() + rounds / 2, intervals.end());
+    return intervals[rounds / 2];
+}
+
+double overhead_ns = 0;
+
+// Time samples * BATCH single calls of op(i), each between its own clock
+// reads less the clock overhead, so percentiles are per operation; setup(i)
+// runs untimed before every BATCH calls
+template <typename Setup, typename Op>
+Result measure(const std::string& name, std::map<std::string, int> params, int samples, Setup setup, Op op) {
+    // Warm-up
+    for (int i = 0; i < std::min(samples, 1000); ++i) {
+        setup(i);
+        for (int k = 0; k < BATCH; ++k) op(i * BATCH + k);
+    }
+
+    const size_t count = static_cast<size_t>(samples) * BATCH;
+    std::vector<double> latencies(count);
+    double total = 0;
+    uint64_t allocations = 0;
+    for (int i = 0; i < samples; ++i) {
+        setup(i);
+        uint64_t allocations_before = allocation_count.load(std::memory_order_relaxed);
+        for (int k = 0; k < BATCH; ++k) {
+            auto start = Clock::now();
+            op(i * BATCH + k);
+            auto end = Clock::now();
+            double ns = std::chrono::duration<double, std::nano>(end - start).count() - overhead_ns;
+            latencies[static_cast<size_t>(i) * BATCH + k] = std::max(ns, 0.0);
+        }
+        allocations += allocation_count.load(std::memory_order_relaxed) - allocations_before;
+    }
+    for (double ns : latencies) total += ns;
+
+    std::sort(latencies.begin(), latencies.end());
+    auto percentile = [&](double q) { return latencies[std::min(count - 1, static_cast<size_t>(q * count))]; };
+
+    Result result;
+    result.name = name;
+    result.params = std::move(params);
+    result.ns_per_op = total / count;
+    result.p50 = percentile(0.50);
+    result.p99 = percentile(0.99);
+    result.p999 = percentile(0.999);
+    result.allocs_per_op = static_cast<double>(allocations) / count;
+    return result;
+}
+
+MBORecord makeOrder(char action, char side, int64_t price, int size, long order_id) {
+    MBORecord record{};
+    record.ts_recv = record.ts_event = 1752739503360677248LL;
+    record.rtype = 160;
+    record.publisher_id = 2;
+    record.instrument_id = 1108;
+    record.action = action;
+    record.side = side;
+    record.price = price;
+    record.size = size;
+    record.order_id = order_id;
+    record.flags = 130;
+    record.sequence = static_cast<uint32_t>(order_id);
+    record.symbol_id = SymbolTable::global().intern("BENCH");
+    return record;
+}
+
+// Book with orders spread over levels price levels on each side
+struct BookFixture {
+    OrderBook book;
+    std::vector<MBORecord> live;
+    long next_id = 1;
+    int levels;
+
+    BookFixture(int level_count, int order_count) : levels(level_count) {
+        live.reserve(order_count);
+        for (int i = 0; i < order_count; ++i) {
+            live.push_back(randomAdd());
+            book.processRecord(live.back());
+        }
+    }
+
+    MBORecord randomAdd() {
+        char side = nextRandom() % 2 == 0 ? 'B' : 'A';
+        int64_t offset = static_cast<int64_t>(nextRandom() % levels) * DEFAULT_TICK_SIZE;
+        int64_t price = side == 'B' ? 100 * PRICE_SCALE - offset : 100 * PRICE_SCALE + DEFAULT_TICK_SIZE + offset;
+        return makeOrder('A', side, price, static_cast<int>(nextRandom() % 100) + 1, next_id++);
+    }
+};
+
+std::vector<Result> runAll(bool quick) {
+    std::vector<Result> results;
+    const int samples = quick ? 2000 : 20000;
+    auto report = [&](Result result) {
+        std::cout << result.id() << ": " << result.ns_per_op << " ns/op, p50 " << result.p50 << ", p99 " << result.p99
+                  << ", p99.9 " << result.p999 << ", " << result.allocs_per_op << " allocs/op" << std::endl;
+        results.push_back(std::move(result));
+    };
+
+    // CSVParser::parseLine over the sample file's lines
+    {
+        std::vector<std::string> lines;
+        std::ifstream input("../data/mbo.csv");
+        std::string line;
+        std::getline(input, line);
+        while (std::getline(input, line)) lines.push_back(line);
+        if (!lines.empty()) {
+            MBORecord record;
+            report(measure("parseLine", {}, samples, [](int) {}, [&](int i) {
+                CSVParser::parseLine(lines[i % lines.size()], record);
+                asm volatile("" : : "r"(&record) : "memory");
+            }));
+        }
+
+        // Timestamp conversions over the lines' ts_recv and ts_event fields:
+        // the general functions and the hour-cached codec the hot paths use
+        std::vector<std::string> texts;
+        std::vector<int64_t> values;
+        for (const std::string& text : lines) {
+            size_t second = text.find(',') + 1;
+            for (std::string_view field : {std::string_view(text).substr(0, second - 1),
+                                           std::string_view(text).substr(second, text.find(',', second) - second)}) {
+                int64_t ns;
+                if (parseTimestamp(field, ns)) {
+                    texts.emplace_back(field);
+                    values.push_back(ns);
+                }
+            }
+        }
+        if (!texts.empty()) {
+            int64_t ns = 0;
+            char out[TIMESTAMP_LENGTH];
+            TimestampCodec codec;
+            report(measure("parseTimestamp", {}, samples, [](int) {}, [&](int i) {
+                parseTimestamp(texts[i % texts.size()], ns);
+                asm volatile("" : : "r"(&ns) : "memory");
+            }));
+            report(measure("TimestampCodec::parse", {}, samples, [](int) {}, [&](int i) {
+                codec.parse(texts[i % texts.size()], ns);
+                asm volatile("" : : "r"(&ns) : "memory");
+            }));
+            report(measure("formatTimestamp", {}, samples, [](int) {}, [&](int i) {
+                formatTimestamp(values[i % values.size()], out);
+                asm volatile("" : : "r"(out) : "memory");
+            }));
+            report(measure("TimestampCodec::format", {}, samples, [](int) {}, [&](int i) {
+                codec.format(values[i % values.size()], out);
+                asm volatile("" : : "r"(out) : "memory");
+            }));
+        }
+    }
+
+    const std::vector<std::pair<int, int>> shapes = quick ? std::vector<std::pair<int, int>>{{10, 1000}, {1000, 100000}}
+                                                          : std::vector<std::pair<int, int>>{{10, 1000}, {100, 10000}, {1000, 100000}};
+    for (const auto& shape : shapes) {
+        std::map<std::string, int> params = {{"levels", shape.first}, {"orders", shape.second}};
+
+        // Orders added by one batch are cancelled before the next, so the book size stays steady
+        {
+            BookFixture fixture(shape.first, shape.second);
+            std::vector<MBORecord> adds(BATCH);
+            bool added = false;
+            report(measure("addOrder", params, samples,
+                [&](int) {
+                    for (auto& add : adds) {
+                        if (added) fixture.book.cancelOrder(add);
+                        add = fixture.randomAdd();
+                    }
+                    added = true;
+                },
+                [&](int i) { fixture.book.addOrder(adds[i % BATCH]); }));
+        }
+        {
+            BookFixture fixture(shape.first, shape.second);
+            std::vector<MBORecord> cancels(BATCH);
+            report(measure("cancelOrder", params, samples,
+                [&](int) {
+                    for (auto& cancel : cancels) {
+                        size_t pick = nextRandom() % fixture.live.size();
+                        cancel = fixture.live[pick];
+                        cancel.action = 'C';
+                        fixture.live[pick] = fixture.randomAdd();
+                        fixture.book.processRecord(fixture.live[pick]);
+                    }
+                },
+                [&](int i) { fixture.book.cancelOrder(cancels[i % BATCH]); }));
+        }
+
+        // T -> F -> C through processRecord, which ends in handleTradeSequence
+        {
+            BookFixture fixture(shape.first, shape.second);
+            std::vector<MBORecord> sequences(3 * BATCH);
+            report(measure("handleTradeSequence", params, samples,
+                [&](int) {
+                    for (int k = 0; k < BATCH; ++k) {
+                        size_t pick = nextRandom() % fixture.live.size();
+                        const MBORecord& resting = fixture.live[pick];
+                        MBORecord trade = resting;
+                        trade.action = 'T';
+                        trade.side = resting.side == 'B' ? 'A' : 'B';
+                        trade.order_id = 0;
+                        MBORecord fill = resting;
+                        fill.action = 'F';
+                        MBORecord cancel = resting;
+                        cancel.action = 'C';
+                        sequences[3 * k] = trade;
+                        sequences[3 * k + 1] = fill;
+                        sequences[3 * k + 2] = cancel;
+                        fixture.live[pick] = fixture.randomAdd();
+                        fixture.book.processRecord(fixture.live[pick]);
+                    }
+                },
+                [&](int i) {
+                    int k = i % BATCH;
+                    fixture.book.processRecord(sequences[3 * k]);
+                    fixture.book.processRecord(sequences[3 * k + 1]);
+                    fixture.book.processRecord(sequences[3 * k + 2]);
+                }));
+        }
+
+        // Snapshot reads and row formatting at MBP-1 / MBP-10 / MBP-50
+        BookFixture fixture(shape.first, shape.second);
+        fixture.book.setViewDepth(MAX_BOOK_DEPTH);
+        MBORecord record = fixture.live.back();
+        for (int depth : {1, BOOK_DEPTH, MAX_BOOK_DEPTH}) {
+            std::map<std::string, int> depth_params = params;
+            depth_params["depth"] = depth;
+            report(measure("getBidLevels", depth_params, samples, [](int) {}, [&](int) {
+                auto levels = fixture.book.getBidLevels(depth);
+                asm volatile("" : : "r"(levels.data()) : "memory");
+            }));
+        }
+
+        BasicMBPFormatter<1> mbp1;
+        BasicMBPFormatter<BOOK_DEPTH> mbp10;
+        BasicMBPFormatter<MAX_BOOK_DEPTH> mbp50;
+        auto formatRows = [&](auto& formatter, int depth) {
+            std::map<std::string, int> depth_params = params;
+            depth_params["depth"] = depth;
+            // A size change before each batch; every row refreshes the levels it touched
+            MBORecord change;
+            report(measure("formatRow", depth_params, samples,
+                [&](int i) {
+                    MBORecord& order = fixture.live[nextRandom() % fixture.live.size()];
+                    order.action = 'M';
+                    order.size = static_cast<int>(i % 50) + 1;
+                    fixture.book.processRecord(order);
+                    change = order;
+                },
+                [&](int i) {
+                    std::string_view row = formatter.formatRow(change, i, fixture.book);
+                    asm volatile("" : : "r"(row.data()) : "memory");
+                }));
+        };
+        formatRows(mbp1, 1);
+        formatRows(mbp10, BOOK_DEPTH);
+        formatRows(mbp50, MAX_BOOK_DEPTH);
+
+        report(measure("generateMBPOutput", params, samples, [](int) {}, [&](int i) {
+            std::string row = fixture.book.generateMBPOutput(record, i);
+            asm volatile("" : : "r"(row.data()) : "memory");
+        }));
+    }
+    return results;
+}
+
+// A book of 100 ask levels sliding down 7 ticks per step: each step adds a
+// new best and cancels the worst level, so the best crosses the ladder's
+// window edge every ~150 steps. Once the window has grown, no level may spill
+// into the overflow and no step may allocate.
+bool checkLadderSlide() {
+    constexpr int LEVELS = 100;
+    constexpr int STEPS = 100000;
+    constexpr int64_t STEP = 7 * DEFAULT_TICK_SIZE;
+    const int64_t start = 10000 * PRICE_SCALE;
+    PriceLadder<false> asks;
+    auto step = [&](int64_t i) {
+        asks.update(start - i * STEP, 10, 1);
+        if (i >= LEVELS) asks.update(start - (i - LEVELS) * STEP, -10, -1);
+    };
+
+    int64_t i = 0;
+    for (; i < 2 * LEVELS; ++i) step(i);
+    uint64_t allocations_before = allocation_count.load(std::memory_order_relaxed);
+    for (; i < STEPS; ++i) step(i);
+    uint64_t allocations = allocation_count.load(std::memory_order_relaxed) - allocations_before;
+
+    if (asks.overflowCount() != 0 || allocations != 0 || asks.levelCount() != LEVELS) {
+        std::cerr << "Error: Sliding ladder spilled " << asks.overflowCount() << " level(s) and allocated "
+                  << allocations << " time(s)" << std::endl;
+        return false;
+    }
+    std::cout << "Sliding ladder: " << STEPS << " steps across the window edge, no spills or allocations" << std::endl;
+    return true;
+}
+
+void writeJson(const std::vector<Result>& results, const std::string& filename) {
+    std::ofstream output(filename);
+    output << "{\n  \"benchmarks\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result& r = results[i];
+        output << "    {\"id\": \"" << r.id() << "\", \"name\": \"" << r.name << "\"";
+        for (const auto& param : r.params) {
+            output << ", \"" << param.first << "\": " << param.second;
+        }
+        output << ", \"ns_per_op\": " << r.ns_per_op << ", \"p50_ns\": " << r.p50 << ", \"p99_ns\": " << r.p99
+               << ", \"p999_ns\": " << r.p999 << ", \"allocs_per_op\": " << r.allocs_per_op << "}"
+               << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    output << "  ]\n}\n";
+}
+
+// ns_per_op by id from a file written by writeJson
+std::map<std::string, double> readBaseline(const std::string& filename) {
+    std::map<std::string, double> baseline;
+    std::ifstream input(filename);
+    std::string line;
+    while (std::getline(input, line)) {
+        size_t id = line.find("\"id\": \"");
+        size_t ns = line.find("\"ns_per_op\": ");
+        if (id == std::string::npos || ns == std::string::npos) continue;
+        id += 7;
+        baseline[line.substr(id, line.find('"', id) - id)] = std::atof(line.c_str() + ns + 13);
+    }
+    return baseline;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::string json_file = "../build/bench_results.json";
+    std::string baseline_file;
+    bool quick = false;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            json_file = argv[++i];
+        } else if (std::strcmp(argv[i], "--baseline") == 0 && i + 1 < argc) {
+            baseline_file = argv[++i];
+        } else if (std::strcmp(argv[i], "--quick") == 0) {
+            quick = true;
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--quick] [--json results.json] [--baseline baseline.json]" << std::endl;
+            return 1;
+        }
+    }
+
+    overhead_ns = clockOverhead();
+    std::cout << "Clock overhead: " << overhead_ns << " ns per timed interval, subtracted from each operation" << std::endl;
+
+    if (!checkLadderSlide()) {
+        return 1;
+    }
+
+    std::vector<Result> results = runAll(quick);
+    writeJson(results, json_file);
+    std::cout << "Results written to: " << json_file << std::endl;
+
+    if (!baseline_file.empty()) {
+        std::map<std::string, double> baseline = readBaseline(baseline_file);
+        if (baseline.empty()) {
+            std::cerr << "Error: No results in baseline " << baseline_file << std::endl;
+            return 1;
+        }
+        std::cout << "\nAgainst " << baseline_file << " (ns/op, change):" << std::endl;
+        for (const Result& r : results) {
+            auto it = baseline.find(r.id());
+            if (it == baseline.end() || it->second <= 0) continue;
+            double change = (r.ns_per_op / it->second - 1.0) * 100.0;
+            std::cout << "  " << r.id() << ": " << it->second << " -> " << r.ns_per_op << " ("
+                      << (change >= 0 ? "+" : "") << change << "%)" << std::endl;
+        }
+    }
+    return 0;
+}
@@ -1,9 +1,34 @@
 #include "orderbook.h"
+#include "mbo_reader.h"
+#include "mbp_formatter.h"
+#include "book_manager.h"
+#include "parallel_replay.h"
+#include "mbo_binary.h"
+#include "mbp_binary.h"
+#include "timestamp.h"
+#include "async_writer.h"
+#include "mbo_generator.h"
+#include "latency_stats.h"
+#include "checkpoint.h"
+#include "replay_index.h"
+#include "live_ingest.h"
 #include <cassert>
 #include <iostream>
 #include <vector>
 #include <string>
 #include <sstream>
+#include <fstream>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <unordered_map>
+#include <algorithm>
+#include <cstdint>
+#include <cmath>
+#include <iterator>
+#include <memory>
+#include <thread>
+#include <unistd.h>
 
 // Test utilities
 class TestFramework {
@@ -77,24 +102,41 @@ MBORecord createRecord(const std::string& ts_recv, const std::string& ts_event,
                       char action, char side, double price, int size, long order_id, 
                       const std::string& symbol = "TEST") {
     MBORecord record;
-    record.ts_recv = ts_recv;
-    record.ts_event = ts_event;
+    parseTimestamp(ts_recv, record.ts_recv);
+    parseTimestamp(ts_event, record.ts_event);
     record.rtype = 160;
     record.publisher_id = 2;
     record.instrument_id = 1108;
     record.action = action;
     record.side = side;
-    record.price = price;
+    record.price = priceFromDouble(price);
     record.size = size;
     record.channel_id = 0;
     record.order_id = order_id;
     record.flags = 130;
     record.ts_in_delta = 165200;
     record.sequence = 851012;
-    record.symbol = symbol;
+    record.symbol_id = SymbolTable::global().intern(symbol);
     return record;
 }
 
+std::string timestampText(int64_t ns) {
+    char text[TIMESTAMP_LENGTH];
+    return std::string(text, formatTimestamp(ns, text));
+}
+
+bool sameRecord(const MBORecord& a, const MBORecord& b) {
+    return a.price == b.price && a.order_id == b.order_id && a.size == b.size && a.action == b.action &&
+           a.side == b.side && a.publisher_id == b.publisher_id && a.instrument_id == b.instrument_id &&
+           a.symbol_id == b.symbol_id && a.ts_recv == b.ts_recv && a.ts_event == b.ts_event &&
+           a.sequence == b.sequence && a.ts_in_delta == b.ts_in_delta && a.channel_id == b.channel_id &&
+           a.rtype == b.rtype && a.flags == b.flags;
+}
+
+const std::string& symbolName(const MBORecord& record) {
+    return SymbolTable::global().name(record.symbol_id);
+}
+
 // Test basic orderbook functionality
 void test_basic_orderbook(TestFramework& tf) {
     std::cout << "\n=== Testing Basic Orderbook Functionality ===" << std::endl;
@@ -116,7 +158,7 @@ void test_basic_orderbook(TestFramework& tf) {
     ask_levels = book.getAskLevels();
     tf.assert_equal(bid_levels.size(), 1, "Should have one bid level after adding bid");
     tf.assert_equal(ask_levels.size(), 0, "Should have no ask levels");
-    tf.assert_equal(bid_levels[0].price, 100.0, "Bid price should be 100.0");
+    tf.assert_equal(priceToDouble(bid_levels[0].price), 100.0, "Bid price should be 100.0");
     tf.assert_equal(bid_levels[0].total_size, 100, "Bid size should be 100");
     tf.assert_equal(bid_levels[0].order_count, 1, "Bid order count should be 1");
     
@@ -129,7 +171,7 @@ void test_basic_orderbook(TestFramework& tf) {
     ask_levels = book.getAskLevels();
     tf.assert_equal(bid_levels.size(), 1, "Should still have one bid level");
     tf.assert_equal(ask_levels.size(), 1, "Should have one ask level");
-    tf.assert_equal(ask_levels[0].price, 101.0, "Ask price should be 101.0");
+    tf.assert_equal(priceToDouble(ask_levels[0].price), 101.0, "Ask price should be 101.0");
     tf.assert_equal(ask_levels[0].total_size, 50, "Ask size should be 50");
     tf.assert_equal(ask_levels[0].order_count, 1, "Ask order count should be 1");
 }
@@ -195,9 +237,9 @@ void test_price_level_ordering(TestFramework& tf) {
     
     auto bid_levels = book.getBidLevels();
     tf.assert_equal(bid_levels.size(), 3, "Should have three bid levels");
-    tf.assert_equal(bid_levels[0].price, 100.0, "Highest bid should be first");
-    tf.assert_equal(bid_levels[1].price, 99.0, "Second highest bid should be second");
-    tf.assert_equal(bid_levels[2].price, 98.0, "Lowest bid should be last");
+    tf.assert_equal(priceToDouble(bid_levels[0].price), 100.0, "Highest bid should be first");
+    tf.assert_equal(priceToDouble(bid_levels[1].price), 99.0, "Second highest bid should be second");
+    tf.assert_equal(priceToDouble(bid_levels[2].price), 98.0, "Lowest bid should be last");
     
     // Test ask ordering
     auto ask1 = createRecord("2025-01-01T10:00:03Z", "2025-01-01T10:00:03Z", 
@@ -213,9 +255,9 @@ void test_price_level_ordering(TestFramework& tf) {
     
     auto ask_levels = book.getAskLevels();
     tf.assert_equal(ask_levels.size(), 3, "Should have three ask levels");
-    tf.assert_equal(ask_levels[0].price, 101.0, "Lowest ask should be first");
-    tf.assert_equal(ask_levels[1].price, 102.0, "Second lowest ask should be second");
-    tf.assert_equal(ask_levels[2].price, 103.0, "Highest ask should be last");
+    tf.assert_equal(priceToDouble(ask_levels[0].price), 101.0, "Lowest ask should be first");
+    tf.assert_equal(priceToDouble(ask_levels[1].price), 102.0, "Second lowest ask should be second");
+    tf.assert_equal(priceToDouble(ask_levels[2].price), 103.0, "Highest ask should be last");
 }
 
 // Test T->F->C sequence handling
@@ -306,13 +348,13 @@ void test_csv_parsing(TestFramework& tf) {
     std::string test_line = "2025-01-01T10:00:00Z,2025-01-01T10:00:00Z,160,2,1108,A,B,100.50,100,0,12345,130,165200,851012,TEST";
     MBORecord record = CSVParser::parseLine(test_line);
     
-    tf.assert_equal(record.ts_recv, "2025-01-01T10:00:00Z", "Timestamp receive should match");
+    tf.assert_equal(timestampText(record.ts_recv), "2025-01-01T10:00:00.000000000Z", "Timestamp receive should match");
     tf.assert_equal(record.action, 'A', "Action should be 'A'");
     tf.assert_equal(record.side, 'B', "Side should be 'B'");
-    tf.assert_equal(record.price, 100.50, "Price should be 100.50");
+    tf.assert_equal(priceToDouble(record.price), 100.50, "Price should be 100.50");
     tf.assert_equal(record.size, 100, "Size should be 100");
     tf.assert_equal(record.order_id, 12345, "Order ID should be 12345");
-    tf.assert_equal(record.symbol, "TEST", "Symbol should be TEST");
+    tf.assert_equal(symbolName(record), "TEST", "Symbol should be TEST");
     
     // Test file parsing
     std::vector<MBORecord> records = CSVParser::parseFile("../data/test_data.csv");
@@ -322,8 +364,1603 @@ void test_csv_parsing(TestFramework& tf) {
         tf.assert_equal(records[0].action, 'R', "First record should be reset action");
         tf.assert_equal(records[1].action, 'A', "Second record should be add action");
         tf.assert_equal(records[1].side, 'B', "Second record should be bid");
-        tf.assert_equal(records[1].price, 100.00, "Second record price should be 100.00");
+        tf.assert_equal(priceToDouble(records[1].price), 100.00, "Second record price should be 100.00");
+    }
+}
+
+// Test zero-copy reader and non-throwing parse errors
+void test_mbo_reader(TestFramework& tf) {
+    std::cout << "\n=== Testing Memory-Mapped MBO Reader ===" << std::endl;
+
+    MBORecord record;
+    ParseError error = CSVParser::parseLine(std::string_view("2025-01-01T10:00:00Z,2025-01-01T10:00:00Z,160,2"), record);
+    tf.assert_true(error == ParseError::MissingFields, "Short line should report missing fields");
+    error = CSVParser::parseLine(std::string_view("2025-01-01T10:00:00Z,2025-01-01T10:00:00Z,160,2,1108,A,B,1.5,100,0,x,130,0,1,TEST"), record);
+    tf.assert_true(error == ParseError::BadInteger, "Non-numeric order id should report bad integer");
+    error = CSVParser::parseLine(std::string_view("2025-01-01 10:00:00,2025-01-01T10:00:00Z,160,2,1108,A,B,1.5,100,0,1,130,0,1,TEST"), record);
+    tf.assert_true(error == ParseError::BadTimestamp, "Non-ISO timestamp should report bad timestamp");
+    error = CSVParser::parseLine(std::string_view("2025-07-17T08:05:03.360677248Z,2025-07-17T08:05:03.360677248Z,160,2,1108,A,B,1.5,100,0,1,130,0,1,ARL"), record);
+    tf.assert_true(error == ParseError::None && record.ts_recv == 1752739503360677248LL, "Timestamps should parse to nanoseconds");
+
+    MBOReader reader;
+    tf.assert_true(reader.open("../data/test_malformed.csv"), "Reader should open test file");
+
+    std::vector<long> order_ids;
+    while (reader.next(record)) {
+        order_ids.push_back(record.order_id);
+    }
+
+    const ParseStats& stats = reader.stats();
+    tf.assert_equal(static_cast<int>(order_ids.size()), 2, "Reader should return only well-formed lines");
+    tf.assert_equal(static_cast<int>(stats.lines), 5, "Reader should count non-blank data lines");
+    tf.assert_equal(static_cast<int>(stats.errors), 3, "Reader should count malformed lines");
+    tf.assert_equal(static_cast<int>(stats.by_error[static_cast<size_t>(ParseError::MissingFields)]), 1, "Missing fields counter");
+    tf.assert_equal(static_cast<int>(stats.by_error[static_cast<size_t>(ParseError::BadPrice)]), 1, "Bad price counter");
+    tf.assert_equal(static_cast<int>(stats.by_error[static_cast<size_t>(ParseError::BadInteger)]), 1, "Bad integer counter");
+    tf.assert_equal(static_cast<int>(stats.first_error_line), 3, "First error line should be reported");
+    tf.assert_equal(symbolName(record), "TEST", "Trailing carriage return should be stripped");
+    if (order_ids.size() == 2) {
+        tf.assert_equal(static_cast<int>(order_ids[1]), 4, "Last record should follow the blank line");
+    }
+}
+
+// Test streaming reader with a small fixed-size buffer
+void test_streaming_reader(TestFramework& tf) {
+    std::cout << "\n=== Testing Streaming MBO Reader ===" << std::endl;
+
+    std::vector<MBORecord> mapped = CSVParser::parseFile("../data/test_data.csv");
+
+    // A 160-byte buffer forces a refill every line or so
+    MBOReader reader;
+    tf.assert_true(reader.open("../data/test_data.csv", ReadMode::Streaming, 160), "Streaming reader should open test file");
+
+    MBORecord record;
+    size_t count = 0;
+    bool all_match = true;
+    while (reader.next(record)) {
+        if (count >= mapped.size() || record.order_id != mapped[count].order_id ||
+            record.ts_recv != mapped[count].ts_recv || record.symbol_id != mapped[count].symbol_id) {
+            all_match = false;
+        }
+        count++;
+    }
+    tf.assert_equal(static_cast<int>(count), static_cast<int>(mapped.size()), "Streaming should read every record");
+    tf.assert_true(all_match, "Streaming records should match mapped records");
+
+    // Lines longer than the buffer are reported, not split
+    tf.assert_true(reader.open("../data/test_malformed.csv", ReadMode::Streaming, 160), "Streaming reader should reopen");
+    count = 0;
+    while (reader.next(record)) {
+        count++;
+    }
+    tf.assert_equal(static_cast<int>(count), 2, "Streaming should skip malformed lines");
+    tf.assert_equal(static_cast<int>(reader.stats().errors), 3, "Streaming should count malformed lines");
+
+    tf.assert_true(reader.open("../data/test_data.csv", ReadMode::Streaming, 64), "Streaming reader should open with tiny buffer");
+    count = 0;
+    while (reader.next(record)) {
+        count++;
+    }
+    tf.assert_equal(static_cast<int>(count), 0, "Lines longer than the buffer should not be returned");
+    tf.assert_true(reader.stats().by_error[static_cast<size_t>(ParseError::LineTooLong)] > 0, "Long lines should be counted");
+}
+
+// Test fixed-point price parsing and formatting
+void test_fixed_point_prices(TestFramework& tf) {
+    std::cout << "\n=== Testing Fixed-Point Prices ===" << std::endl;
+
+    MBORecord a = CSVParser::parseLine("2025-01-01T10:00:00Z,2025-01-01T10:00:00Z,160,2,1108,A,B,100.1,10,0,1,130,0,1,TEST");
+    MBORecord b = CSVParser::parseLine("2025-01-01T10:00:00Z,2025-01-01T10:00:00Z,160,2,1108,A,B,100.100000000,20,0,2,130,0,2,TEST");
+    tf.assert_true(a.price == 100100000000LL, "Price should parse to exact 1e-9 ticks");
+    tf.assert_true(a.price == b.price, "Equal decimal prices should produce equal ticks");
+
+    OrderBook book;
+    book.processRecord(a);
+    book.processRecord(b);
+    auto bid_levels = book.getBidLevels();
+    tf.assert_equal(static_cast<int>(bid_levels.size()), 1, "Equal prices should share one level");
+
+    MBORecord record;
+    tf.assert_true(CSVParser::parseLine(std::string_view("2025-01-01T10:00:00Z,2025-01-01T10:00:00Z,160,2,1108,A,B,1.2.3,10,0,1,130,0,1,TEST"), record) == ParseError::BadPrice,
+                   "Malformed price should report bad price");
+    size_t symbols = SymbolTable::global().size();
+    CSVParser::parseLine(std::string_view("2025-01-01T10:00:00Z,2025-01-01T10:00:00Z,160,2,1108,A,B,1.5,10,0,x,130,0,1,JUNK1"), record);
+    CSVParser::parseLine(std::string_view("2025-01-01T10:00:00Z,2025-01-01T10:00:00Z,160,2,1108,A,B,1..5,10,0,1,130,0,1,JUNK2"), record);
+    tf.assert_true(SymbolTable::global().size() == symbols, "Rejected lines should not intern their symbols");
+
+    char text[24];
+    tf.assert_equal(std::string(text, formatPrice(5510000000LL, text)), "5.51", "Format two decimals");
+    tf.assert_equal(std::string(text, formatPrice(13575000000LL, text)), "13.58", "Format rounds half away from zero");
+    tf.assert_equal(std::string(text, formatPrice(-100000000000LL, text)), "-100.00", "Format negative price");
+    tf.assert_equal(std::string(text, formatPrice(0, text)), "0.00", "Format zero price");
+}
+
+// Test dense price ladder against a std::map reference
+void test_price_ladder(TestFramework& tf) {
+    std::cout << "\n=== Testing Dense Price Ladder ===" << std::endl;
+
+    PriceLadder<true> bids;
+    PriceLadder<false> asks;
+    std::map<int64_t, PriceLevel> bid_ref;
+    std::map<int64_t, PriceLevel> ask_ref;
+
+    auto apply = [](std::map<int64_t, PriceLevel>& ref, int64_t price, int size_delta, int count_delta) {
+        auto it = ref.find(price);
+        if (it != ref.end()) {
+            it->second.total_size += size_delta;
+            it->second.order_count += count_delta;
+            if (it->second.order_count <= 0 || it->second.total_size <= 0) ref.erase(it);
+        } else if (size_delta > 0 && count_delta > 0) {
+            ref.emplace(price, PriceLevel(price, size_delta, count_delta));
+        }
+    };
+
+    // Random walk wide enough to force re-centering, with some off-grid and far prices
+    uint64_t state = 12345;
+    auto next_random = [&state]() {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        return static_cast<uint32_t>(state >> 33);
+    };
+
+    bool consistent = true;
+    int64_t mid = 100 * PRICE_SCALE;
+    for (int i = 0; i < 20000; ++i) {
+        mid += (static_cast<int64_t>(next_random() % 201) - 100) * DEFAULT_TICK_SIZE;
+        int64_t offset = static_cast<int64_t>(next_random() % 60) * DEFAULT_TICK_SIZE;
+        if (next_random() % 50 == 0) offset += DEFAULT_TICK_SIZE / 2;           // off-grid
+        if (next_random() % 100 == 0) offset += 10000 * DEFAULT_TICK_SIZE;      // far from the touch
+        bool add = next_random() % 3 != 0;
+        int size = static_cast<int>(next_random() % 100) + 1;
+        int size_delta = add ? size : -size;
+        int count_delta = add ? 1 : -1;
+
+        if (next_random() % 2 == 0) {
+            bids.update(mid - offset, size_delta, count_delta);
+            apply(bid_ref, mid - offset, size_delta, count_delta);
+        } else {
+            asks.update(mid + offset, size_delta, count_delta);
+            apply(ask_ref, mid + offset, size_delta, count_delta);
+        }
+
+        if (i % 97 == 0) {
+            PriceLevel levels[10];
+            int n = bids.top(levels, 10);
+            auto it = bid_ref.rbegin();
+            for (int k = 0; k < n; ++k, ++it) {
+                if (it == bid_ref.rend() || it->first != levels[k].price || it->second.total_size != levels[k].total_size) consistent = false;
+            }
+            if (n != static_cast<int>(std::min<size_t>(10, bid_ref.size()))) consistent = false;
+
+            n = asks.top(levels, 10);
+            auto ait = ask_ref.begin();
+            for (int k = 0; k < n; ++k, ++ait) {
+                if (ait == ask_ref.end() || ait->first != levels[k].price || ait->second.order_count != levels[k].order_count) consistent = false;
+            }
+            if (n != static_cast<int>(std::min<size_t>(10, ask_ref.size()))) consistent = false;
+            if (bids.levelCount() != bid_ref.size() || asks.levelCount() != ask_ref.size()) consistent = false;
+        }
+    }
+
+    tf.assert_true(consistent, "Ladder top levels should match std::map reference");
+    tf.assert_true(bids.find(123) == nullptr, "Missing level lookup should return null");
+    bids.clear();
+    tf.assert_equal(static_cast<int>(bids.levelCount()), 0, "Cleared ladder should be empty");
+
+    // The window grows from MIN_WINDOW to hold deeper levels, and only past WINDOW spills
+    PriceLadder<false> growing;
+    int64_t best = 100 * PRICE_SCALE;
+    for (int64_t ticks : {0, 40, 1000, 2047, 5000}) {
+        growing.update(best + ticks * DEFAULT_TICK_SIZE, 10, 1);
+    }
+    PriceLevel levels[5];
+    int n = growing.top(levels, 5);
+    tf.assert_true(n == 5 && levels[0].price == best && levels[3].price == best + 2047 * DEFAULT_TICK_SIZE &&
+                       levels[4].price == best + 5000 * DEFAULT_TICK_SIZE,
+                   "Grown ladder should keep every level in price order");
+    tf.assert_equal(static_cast<int>(growing.overflowCount()), 1, "Only levels beyond the largest window should spill");
+
+    // A best moving past the window edge re-centers and grows the window, so
+    // the levels behind it stay dense
+    PriceLadder<true> rising;
+    for (int ticks = 0; ticks < 10; ++ticks) rising.update(best + ticks * DEFAULT_TICK_SIZE, 10, 1);
+    for (int step = 1; step <= 40; ++step) rising.update(best + (9 + step * 40) * DEFAULT_TICK_SIZE, 10, 1);
+    PriceLevel risen[50];
+    n = rising.top(risen, 50);
+    tf.assert_true(n == 50 && risen[0].price == best + 1609 * DEFAULT_TICK_SIZE && risen[49].price == best,
+                   "Re-centered ladder should keep every level in price order");
+    tf.assert_equal(static_cast<int>(rising.overflowCount()), 0, "Levels behind a new best should stay dense");
+
+    // Emptying the dense levels re-centers on the overflow's best and takes in the rest
+    PriceLadder<false> far;
+    far.update(best, 10, 1);
+    for (int64_t ticks : {3000, 3100, 3500}) far.update(best + ticks * DEFAULT_TICK_SIZE, 10, 1);
+    int spilled = static_cast<int>(far.overflowCount());
+    far.update(best, -10, -1);
+    tf.assert_true(spilled == 3 && far.overflowCount() == 0 && far.levelCount() == 3 &&
+                       far.find(best + 3500 * DEFAULT_TICK_SIZE) != nullptr,
+                   "Overflow levels should move back into the array once the dense ones are gone");
+}
+
+// Test open-addressing order table against std::unordered_map
+void test_order_table(TestFramework& tf) {
+    std::cout << "\n=== Testing Order Table ===" << std::endl;
+
+    OrderTable table(16);
+    std::unordered_map<long, Order> reference;
+
+    uint64_t state = 777;
+    auto next_random = [&state]() {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        return state >> 33;
+    };
+
+    bool consistent = true;
+    for (int i = 0; i < 50000; ++i) {
+        long id = static_cast<long>(next_random() % 5000) * 7919;
+        if (next_random() % 3 != 0) {
+            Order order(id, static_cast<int64_t>(i), i % 100, 'B');
+            table.insert(order);
+            reference[id] = order;
+        } else {
+            Order removed;
+            bool found = table.remove(id, removed);
+            auto it = reference.find(id);
+            if (found != (it != reference.end())) consistent = false;
+            if (found && (removed.price != it->second.price || removed.size != it->second.size)) consistent = false;
+            if (it != reference.end()) reference.erase(it);
+        }
+    }
+
+    for (const auto& entry : reference) {
+        const Order* order = table.find(entry.first);
+        if (!order || order->price != entry.second.price) consistent = false;
+    }
+    size_t visited = 0;
+    table.forEach([&visited](const Order&) { visited++; });
+
+    tf.assert_true(consistent, "Order table should match std::unordered_map");
+    tf.assert_equal(static_cast<int>(table.size()), static_cast<int>(reference.size()), "Order table size should match");
+    tf.assert_equal(static_cast<int>(visited), static_cast<int>(reference.size()), "forEach should visit every order");
+
+    OrderTable::Stats stats = table.stats();
+    tf.assert_true(stats.load_factor > 0.0 && stats.load_factor <= 0.875, "Load factor should stay at or below 7/8");
+    tf.assert_true(stats.max_probe_length >= 1 && stats.average_probe_length < 4.0, "Probe lengths should stay short");
+    tf.assert_true(stats.pool_capacity <= 5000, "Pool slots of removed orders should be recycled");
+
+    table.clear();
+    tf.assert_true(table.find(7919) == nullptr && table.empty(), "Cleared table should be empty");
+}
+
+// Test incremental top-of-book cache and change reports
+void test_top_levels_cache(TestFramework& tf) {
+    std::cout << "\n=== Testing Incremental Top-of-Book Cache ===" << std::endl;
+
+    OrderBook book;
+    uint64_t state = 4242;
+    auto next_random = [&state]() {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        return state >> 33;
+    };
+
+    auto same = [](const PriceLevel& a, const PriceLevel& b) {
+        return a.price == b.price && a.total_size == b.total_size && a.order_count == b.order_count;
+    };
+
+    bool views_match = true;
+    bool masks_cover = true;
+    int unchanged_rows = 0;
+    std::vector<long> live;
+    TopLevels previous_bids;
+    TopLevels previous_asks;
+
+    for (int i = 0; i < 20000; ++i) {
+        MBORecord record;
+        if (live.empty() || next_random() % 2 == 0) {
+            char side = next_random() % 2 == 0 ? 'B' : 'A';
+            double price = side == 'B' ? 99.0 - (next_random() % 30) * 0.01 : 101.0 + (next_random() % 30) * 0.01;
+            record = createRecord("2025-01-01T10:00:00Z", "2025-01-01T10:00:00Z", 'A', side, price,
+                                  static_cast<int>(next_random() % 100) + 1, i + 1);
+            live.push_back(i + 1);
+        } else {
+            size_t pick = next_random() % live.size();
+            record = createRecord("2025-01-01T10:00:00Z", "2025-01-01T10:00:00Z", 'C', 'B', 0.0, 0, live[pick]);
+            live[pick] = live.back();
+            live.pop_back();
+        }
+        book.processRecord(record);
+
+        // Cached view must equal a fresh ladder scan
+        auto deep_bids = book.getBidLevels(BOOK_DEPTH + 1);
+        auto deep_asks = book.getAskLevels(BOOK_DEPTH + 1);
+        const TopLevels& bids = book.topBids();
+        const TopLevels& asks = book.topAsks();
+        if (bids.count != std::min<int>(BOOK_DEPTH, deep_bids.size()) || asks.count != std::min<int>(BOOK_DEPTH, deep_asks.size())) {
+            views_match = false;
+        }
+        for (int k = 0; k < bids.count && views_match; ++k) views_match = same(bids.levels[k], deep_bids[k]);
+        for (int k = 0; k < asks.count && views_match; ++k) views_match = same(asks.levels[k], deep_asks[k]);
+
+        // Every index outside the change masks must be untouched
+        const BookChange& change = book.lastChange();
+        for (int k = 0; k < BOOK_DEPTH; ++k) {
+            bool bid_same = (k >= bids.count && k >= previous_bids.count) ||
+                            (k < bids.count && k < previous_bids.count && same(bids.levels[k], previous_bids.levels[k]));
+            bool ask_same = (k >= asks.count && k >= previous_asks.count) ||
+                            (k < asks.count && k < previous_asks.count && same(asks.levels[k], previous_asks.levels[k]));
+            if ((!bid_same && !(change.bid_mask >> k & 1)) || (!ask_same && !(change.ask_mask >> k & 1))) {
+                masks_cover = false;
+            }
+        }
+        if (!change.any()) unchanged_rows++;
+        previous_bids = bids;
+        previous_asks = asks;
+    }
+
+    tf.assert_true(views_match, "Cached top levels should match a full ladder scan");
+    tf.assert_true(masks_cover, "Change masks should cover every changed view index");
+    tf.assert_true(unchanged_rows > 0, "Deep updates should report no visible change");
+}
+
+// Test allocation-free incremental row formatter
+void test_mbp_formatter(TestFramework& tf) {
+    std::cout << "\n=== Testing MBP Row Formatter ===" << std::endl;
+
+    char text[24];
+    tf.assert_equal(std::string(text, writeSigned(text, 0) - text), "0", "Format zero");
+    tf.assert_equal(std::string(text, writeSigned(text, -165200) - text), "-165200", "Format negative integer");
+    tf.assert_equal(std::string(text, writeSigned(text, INT64_MIN) - text), "-9223372036854775808", "Format INT64_MIN");
+    tf.assert_equal(std::string(text, writeUnsigned(text, UINT64_MAX) - text), "18446744073709551615", "Format UINT64_MAX");
+
+    // Incremental rows must equal a full reformat of every row
+    std::vector<MBORecord> records = CSVParser::parseFile("../data/mbo.csv");
+    OrderBook book;
+    MBPFormatter formatter;
+    bool all_match = !records.empty();
+    int row_index = 0;
+    for (const auto& record : records) {
+        book.processRecord(record);
+        std::string_view row = formatter.formatRow(record, row_index, book);
+        std::string full = book.generateMBPOutput(record, row_index);
+        if (row.size() != full.size() + 1 || row.substr(0, full.size()) != full || row.back() != '\n') {
+            all_match = false;
+        }
+        row_index++;
+    }
+    tf.assert_true(all_match, "Incremental rows should match full reformat for data/mbo.csv");
+}
+
+// Test per-instrument book routing
+void test_book_manager(TestFramework& tf) {
+    std::cout << "\n=== Testing Per-Instrument Book Manager ===" << std::endl;
+
+    BookManager books;
+    auto make = [](int publisher, int instrument, const std::string& symbol, char action, char side,
+                   double price, int size, long order_id) {
+        MBORecord record = createRecord("2025-01-01T10:00:00Z", "2025-01-01T10:00:00Z", action, side, price, size, order_id, symbol);
+        record.publisher_id = publisher;
+        record.instrument_id = instrument;
+        return record;
+    };
+
+    // Same order ids in different instruments must not collide
+    std::vector<MBORecord> records = {
+        make(2, 1108, "ARL", 'A', 'B', 10.0, 100, 1),
+        make(2, 2000, "XYZ", 'A', 'B', 50.0, 10, 1),
+        make(3, 1108, "ARL", 'A', 'A', 11.0, 5, 1),
+        make(2, 1108, "ARL", 'A', 'B', 10.5, 200, 2),
+        make(2, 2000, "XYZ", 'C', 'B', 50.0, 10, 1),
+    };
+    for (const auto& record : records) {
+        BookEntry& entry = books.route(record);
+        entry.book.processRecord(record);
+    }
+
+    tf.assert_equal(static_cast<int>(books.size()), 3, "Each (publisher, instrument) should get its own book");
+    BookEntry* arl = books.find(2, 1108);
+    BookEntry* xyz = books.find(2, 2000);
+    BookEntry* arl3 = books.find(3, 1108);
+    tf.assert_true(arl && xyz && arl3 && !books.find(9, 9), "Books should be found by key");
+    if (arl && xyz && arl3) {
+        tf.assert_equal(arl->book.topBids().count, 2, "ARL book should hold both bids");
+        tf.assert_equal(xyz->book.topBids().count, 0, "XYZ cancel should not touch ARL order 1");
+        tf.assert_equal(arl3->book.topAsks().count, 1, "Publisher 3 book should be separate");
+        tf.assert_true(arl->symbol_id == arl3->symbol_id, "Same symbol should be interned once");
+        tf.assert_equal(books.symbols().name(xyz->symbol_id), "XYZ", "Symbol id should resolve to its name");
+        tf.assert_true(&books.route(records[0]) == arl, "Routing should return the existing book");
+    }
+
+    // Index growth keeps every book reachable
+    for (int i = 0; i < 500; ++i) {
+        books.route(make(1, 10000 + i, "S" + std::to_string(i), 'A', 'B', 1.0, 1, i));
+    }
+    bool all_found = true;
+    for (int i = 0; i < 500; ++i) {
+        BookEntry* entry = books.find(1, 10000 + i);
+        if (!entry || entry->instrument_id != static_cast<uint32_t>(10000 + i)) all_found = false;
+    }
+    tf.assert_true(all_found && books.size() == 503, "Books should stay reachable after index growth");
+}
+
+// Test multi-threaded replay against the single-threaded one
+void test_parallel_replay(TestFramework& tf) {
+    std::cout << "\n=== Testing Parallel Replay ===" << std::endl;
+
+    // Interleave three copies of the sample data as different instruments
+    const std::string input_file = "../build/test_parallel_input.csv";
+    {
+        std::ifstream sample("../data/mbo.csv");
+        std::ofstream input(input_file);
+        std::string line;
+        std::getline(sample, line);
+        input << line << "\n";
+        const char* instruments[] = {"1108", "2000", "3000"};
+        for (int count = 0; count < 600 && std::getline(sample, line); ++count) {
+            for (const char* instrument : instruments) {
+                // instrument_id is the fifth field
+                size_t pos = 0;
+                for (int field = 0; field < 4; ++field) pos = line.find(',', pos) + 1;
+                size_t end = line.find(',', pos);
+                input << line.substr(0, pos) << instrument << line.substr(end) << "\n";
+            }
+        }
+    }
+
+    std::ostringstream expected;
+    BookManager books;
+    MBOReader reader;
+    tf.assert_true(reader.open(input_file), "Reader should open generated input");
+    MBORecord record;
+    long row_index = 0;
+    while (reader.next(record)) {
+        BookEntry& entry = books.route(record);
+        entry.book.processRecord(record);
+        std::string_view row = entry.formatter.formatRow(record, row_index++, entry.book);
+        expected.write(row.data(), row.size());
+    }
+    tf.assert_equal(static_cast<int>(books.size()), 3, "Generated input should hold three instruments");
+
+    // Small batches exercise the read-ahead and batch boundaries
+    bool all_match = true;
+    for (int threads = 1; threads <= 4; ++threads) {
+        for (size_t batch : {size_t(7), size_t(1000)}) {
+            ParallelReplay replay(threads, batch);
+            std::ostringstream actual;
+            reader.open(input_file);
+            size_t rows = replay.run(reader, actual);
+            size_t total_books = 0;
+            for (size_t i = 0; i < replay.shardCount(); ++i) {
+                total_books += replay.shard(i).size();
+            }
+            if (rows != static_cast<size_t>(row_index) || actual.str() != expected.str() || total_books != 3) {
+                all_match = false;
+            }
+        }
+    }
+    tf.assert_true(all_match, "Parallel output should be byte-identical for 1-4 threads");
+
+    // The same rows through the background writer, as --threads writes them
+    const std::string output_file = "../build/test_parallel_replay.out";
+    {
+        ParallelReplay replay(3, 1000);
+        AsyncWriter writer;
+        AsyncWriter::Options options;
+        options.buffer_size = 4096;
+        writer.open(output_file, options);
+        reader.open(input_file);
+        replay.run(reader, writer);
+        writer.close();
+    }
+    std::ifstream written(output_file, std::ios::binary);
+    std::ostringstream written_text;
+    written_text << written.rdbuf();
+    tf.assert_true(written_text.str() == expected.str(), "Parallel output through AsyncWriter should be byte-identical");
+    std::remove(output_file.c_str());
+
+    ParallelReplay replay(2);
+    std::ostringstream empty;
+    tf.assert_true(reader.open("../data/test_malformed.csv"), "Reader should open malformed file");
+    tf.assert_equal(static_cast<int>(replay.run(reader, empty)), 2, "Parallel replay should skip malformed lines");
+
+    std::remove(input_file.c_str());
+}
+
+// Test timestamp conversion and the binary MBO format
+void test_binary_format(TestFramework& tf) {
+    std::cout << "\n=== Testing Binary MBO Format ===" << std::endl;
+
+    int64_t ns = 0;
+    char text[TIMESTAMP_LENGTH];
+    tf.assert_true(parseTimestamp("2025-07-17T08:05:03.360677248Z", ns) && ns == 1752739503360677248LL,
+                   "Full timestamp should parse to epoch nanoseconds");
+    tf.assert_equal(std::string(text, formatTimestamp(ns, text)), "2025-07-17T08:05:03.360677248Z",
+                    "Timestamp should format back unchanged");
+    tf.assert_true(parseTimestamp("2025-01-01T10:00:00Z", ns) &&
+                   std::string(text, formatTimestamp(ns, text)) == "2025-01-01T10:00:00.000000000Z",
+                   "Timestamp without fraction should parse");
+    tf.assert_true(parseTimestamp("1969-12-31T23:59:59.5Z", ns) && ns == -500000000LL,
+                   "Short fraction before the epoch should parse");
+    tf.assert_equal(std::string(text, formatTimestamp(ns, text)), "1969-12-31T23:59:59.500000000Z",
+                    "Pre-epoch timestamp should format");
+    tf.assert_true(!parseTimestamp("2025-01-01 10:00:00Z", ns) && !parseTimestamp("2025-13-01T10:00:00Z", ns) &&
+                   !parseTimestamp("2025-01-01T10:00:00.Z", ns) && !parseTimestamp("", ns),
+                   "Malformed timestamps should be rejected");
+
+    // Round trip the test data through a binary file
+    const std::string binary_file = "../build/test_binary.bin";
+    std::vector<MBORecord> records = CSVParser::parseFile("../data/test_data.csv");
+    BinaryMBOWriter writer;
+    tf.assert_true(writer.open(binary_file), "Binary writer should open");
+    for (const auto& record : records) {
+        writer.write(record);
+    }
+    tf.assert_true(writer.close() && writer.recordCount() == records.size(), "Binary writer should write every record");
+
+    for (ReadMode mode : {ReadMode::Mapped, ReadMode::Streaming}) {
+        MBOReader reader;
+        tf.assert_true(reader.open(binary_file, mode, 100) && reader.isBinary(), "Reader should detect binary input");
+        MBORecord record;
+        size_t count = 0;
+        bool all_match = true;
+        while (reader.next(record)) {
+            if (count >= records.size() || !sameRecord(record, records[count])) {
+                all_match = false;
+            }
+            count++;
+        }
+        tf.assert_true(all_match && count == records.size(), "Binary records should match the CSV records");
+    }
+
+    // A corrupted header is rejected instead of misread
+    {
+        std::fstream file(binary_file, std::ios::in | std::ios::out | std::ios::binary);
+        uint32_t version = 99;
+        file.seekp(8);
+        file.write(reinterpret_cast<const char*>(&version), sizeof(version));
+    }
+    MBOReader reader;
+    tf.assert_true(!reader.open(binary_file), "Unknown binary version should fail to open");
+    std::remove(binary_file.c_str());
+}
+
+// Test binary MBP-10 output in both layouts against the CSV rows
+void test_mbp_binary_output(TestFramework& tf) {
+    std::cout << "\n=== Testing Binary MBP-10 Output ===" << std::endl;
+
+    std::vector<MBORecord> records = CSVParser::parseFile("../data/mbo.csv");
+    const std::string fixed_file = "../build/test_mbp.bin";
+    const std::string columnar_file = "../build/test_mbp.col";
+
+    // Replay once, keeping the CSV rows and writing both binary layouts
+    std::vector<std::string> expected;
+    {
+        BookManager books;
+        MBPFileWriter fixed;
+        MBPFileWriter columnar;
+        tf.assert_true(fixed.open(fixed_file, MBPLayout::Fixed), "Fixed-width writer should open");
+        tf.assert_true(columnar.open(columnar_file, MBPLayout::Columnar, 100), "Columnar writer should open");
+        long row_index = 0;
+        for (const auto& record : records) {
+            BookEntry& entry = books.route(record);
+            entry.book.processRecord(record);
+            expected.emplace_back(entry.formatter.formatRow(record, row_index++, entry.book));
+            fixed.write(record, entry.book);
+            columnar.write(record, entry.book);
+        }
+        tf.assert_true(fixed.close() && columnar.close(), "Binary writers should close cleanly");
+    }
+
+    for (const std::string& file : {fixed_file, columnar_file}) {
+        MBPReader reader;
+        tf.assert_true(reader.open(file), "Reader should open " + file);
+        tf.assert_equal(static_cast<int>(reader.recordCount()), static_cast<int>(records.size()), "Header should hold the row count");
+
+        BinaryMBPRecord record;
+        std::vector<char> buffer(MBP_ROW_MAX_SIZE + 64);
+        size_t count = 0;
+        bool all_match = true;
+        while (reader.next(record)) {
+            size_t length = formatMBPRecord(record, static_cast<long>(count), reader.symbol(record.symbol_id), buffer.data());
+            if (count >= expected.size() || std::string(buffer.data(), length) != expected[count]) {
+                all_match = false;
+            }
+            count++;
+        }
+        tf.assert_true(all_match && count == expected.size() && !reader.failed(), "Exported rows should equal the CSV rows");
+    }
+
+    // Truncating a columnar chunk is reported, not misread
+    std::ifstream in(columnar_file, std::ios::binary);
+    std::string bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    in.close();
+    std::ofstream(columnar_file, std::ios::binary | std::ios::trunc).write(bytes.data(), 200);
+    MBPReader reader;
+    tf.assert_true(!reader.open(columnar_file), "Truncated file should fail to open");
+
+    std::remove(fixed_file.c_str());
+    std::remove(columnar_file.c_str());
+}
+
+// Test parallel parseFile against the serial path
+void test_parallel_parsing(TestFramework& tf) {
+    std::cout << "\n=== Testing Parallel CSV Parsing ===" << std::endl;
+
+    // Sample data with blank and malformed lines spread across chunks
+    const std::string input_file = "../build/test_parallel_parse.csv";
+    {
+        std::ifstream sample("../data/mbo.csv");
+        std::ofstream input(input_file);
+        std::string line;
+        for (int count = 0; std::getline(sample, line); ++count) {
+            input << line << "\n";
+            if (count == 1500) input << "\n";
+            if (count == 2000) input << "bad,line\n";
+            if (count == 4000) input << "2025-01-01T10:00:00Z,2025-01-01T10:00:00Z,160,2,1108,A,B,x,1,0,1,0,0,1,TEST\n";
+        }
+        input << "no,trailing,newline";
+    }
+
+    ParseStats serial_stats;
+    std::vector<MBORecord> serial = CSVParser::parseFile(input_file, 1, &serial_stats);
+    tf.assert_equal(static_cast<int>(serial_stats.errors), 3, "Serial parse should count malformed lines");
+
+    bool all_match = true;
+    for (int threads : {2, 3, 8}) {
+        ParseStats stats;
+        std::vector<MBORecord> parallel = CSVParser::parseFile(input_file, threads, &stats);
+        if (parallel.size() != serial.size() || stats.lines != serial_stats.lines ||
+            stats.errors != serial_stats.errors || stats.first_error_line != serial_stats.first_error_line ||
+            stats.first_error != serial_stats.first_error ||
+            stats.by_error[static_cast<size_t>(ParseError::BadPrice)] != 1) {
+            all_match = false;
+            continue;
+        }
+        for (size_t i = 0; i < serial.size(); ++i) {
+            if (parallel[i].order_id != serial[i].order_id || parallel[i].ts_recv != serial[i].ts_recv ||
+                parallel[i].price != serial[i].price || parallel[i].action != serial[i].action) {
+                all_match = false;
+            }
+        }
+    }
+    tf.assert_true(all_match, "Parallel records and error stats should equal the serial parse");
+    tf.assert_equal(static_cast<int>(serial_stats.first_error_line), 2003, "First error line should count the header and blank line");
+
+    // Offsets past each record match MBOReader, and parsing from one of them
+    // yields the records after it, as a batch restart does
+    std::vector<uint64_t> reader_positions;
+    {
+        MBOReader reader;
+        MBORecord record;
+        reader.open(input_file);
+        while (reader.next(record)) reader_positions.push_back(reader.position());
+    }
+    bool resume_matches = true;
+    for (int threads : {1, 3}) {
+        std::vector<MBORecord> records;
+        std::vector<uint64_t> positions;
+        if (!CSVParser::parseFileFrom(input_file, 0, records, &positions, threads) || positions != reader_positions) {
+            resume_matches = false;
+            continue;
+        }
+        size_t from = serial.size() / 2;
+        std::vector<MBORecord> rest;
+        if (!CSVParser::parseFileFrom(input_file, positions[from], rest, nullptr, threads) ||
+            rest.size() != serial.size() - from - 1 || rest.front().order_id != serial[from + 1].order_id ||
+            rest.back().order_id != serial.back().order_id) {
+            resume_matches = false;
+        }
+    }
+    tf.assert_true(resume_matches, "Record offsets should match MBOReader and resume after the record");
+    std::vector<MBORecord> rejected;
+    tf.assert_true(!CSVParser::parseFileFrom(input_file, reader_positions[0] + 1, rejected, nullptr, 3),
+                   "A start inside a line should be rejected");
+
+    std::remove(input_file.c_str());
+}
+
+// Test the background output writer with small buffers to force stalls
+void test_async_writer(TestFramework& tf) {
+    std::cout << "\n=== Testing Async Writer ===" << std::endl;
+
+    const std::string output_file = "../build/test_async_writer.out";
+    auto readAll = [&]() {
+        std::ifstream input(output_file, std::ios::binary);
+        std::ostringstream content;
+        content << input.rdbuf();
+        return content.str();
+    };
+
+    // Appends of varying length, some larger than a buffer
+    std::string expected;
+    for (int i = 0; i < 20000; ++i) {
+        expected += "row " + std::to_string(i) + std::string(i % 97, 'x') + "\n";
+        if (i % 5000 == 0) expected += std::string(10000, 'a' + i % 26);
+    }
+
+    for (bool direct : {false, true}) {
+        AsyncWriter::Options options;
+        options.buffer_size = 4096;
+        options.buffer_count = 2;
+        options.direct_io = direct;
+
+        AsyncWriter writer;
+        tf.assert_true(writer.open(output_file, options), "Writer should open the output file");
+        size_t start = 0;
+        while (start < expected.size()) {
+            size_t end = expected.find('\n', start) + 1;
+            writer.append(expected.data() + start, end - start);
+            start = end;
+        }
+        AsyncWriter::Stats stats = writer.stats();
+        tf.assert_true(writer.close(), "Writer should close cleanly");
+        tf.assert_true(stats.bytes == expected.size(), "Writer should count every appended byte");
+        tf.assert_true(readAll() == expected,
+                       direct ? "O_DIRECT (or fallback) output should match the appended bytes"
+                              : "Output should match the appended bytes in order");
+    }
+
+    // Empty output and closing twice
+    AsyncWriter writer;
+    tf.assert_true(writer.open(output_file), "Writer should reopen the output file");
+    tf.assert_true(writer.close() && !writer.close(), "Second close should report nothing to close");
+    tf.assert_true(readAll().empty(), "Writer without appends should leave an empty file");
+
+    // An idle writer blocks instead of polling
+    tf.assert_true(writer.open(output_file), "Writer should open for the idle check");
+    writer.append("idle\n");
+    writer.flush();
+    auto cpuNs = []() {
+        timespec now;
+        clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &now);
+        return static_cast<int64_t>(now.tv_sec) * 1000000000LL + now.tv_nsec;
+    };
+    int64_t cpu_before = cpuNs();
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    int64_t idle_cpu = cpuNs() - cpu_before;
+    tf.assert_true(writer.close() && readAll() == "idle\n", "Parked writer should still write and close");
+    tf.assert_true(idle_cpu < 2000000, "Idle writer should use almost no CPU");
+
+    // A failed buffer allocation leaves an existing file untouched
+    AsyncWriter::Options huge;
+    huge.buffer_size = size_t(1) << 62;
+    tf.assert_true(!writer.open(output_file, huge) && !writer.isOpen(), "Unallocatable buffers should fail open");
+    tf.assert_true(readAll() == "idle\n", "Failed open should not truncate the file");
+
+    std::remove(output_file.c_str());
+}
+
+// Test change-only emission and the depth column
+void test_change_only_emission(TestFramework& tf) {
+    std::cout << "\n=== Testing Change-Only Emission ===" << std::endl;
+
+    // Twelve bid levels: 100.00 down to 98.90
+    OrderBook book;
+    MBORecord deep;
+    for (int i = 0; i < 12; ++i) {
+        deep = createRecord("2025-01-01T10:00:00Z", "2025-01-01T10:00:00Z", 'A', 'B', 100.0 - 0.1 * i, 10, i + 1);
+        book.processRecord(deep);
+    }
+    tf.assert_true(!book.lastChange().any(), "Add below the view should change nothing visible");
+    tf.assert_true(!emitsRow(EmitMode::BookChanges, deep, book) && emitsRow(EmitMode::AllRecords, deep, book),
+                   "Only all-records mode should emit an invisible add");
+
+    auto insert = createRecord("2025-01-01T10:00:01Z", "2025-01-01T10:00:01Z", 'A', 'B', 99.75, 5, 100);
+    book.processRecord(insert);
+    tf.assert_equal(book.lastChange().depth(), 3, "Insert between levels should report its index");
+    tf.assert_true(book.generateMBPOutput(insert, 0).find(",A,B,3,99.75,5,") != std::string::npos,
+                   "Row should carry the changed depth");
+
+    book.processRecord(createRecord("2025-01-01T10:00:02Z", "2025-01-01T10:00:02Z", 'C', 'B', 98.9, 10, 12));
+    tf.assert_true(!book.lastChange().any(), "Cancel below the view should change nothing visible");
+    book.processRecord(createRecord("2025-01-01T10:00:03Z", "2025-01-01T10:00:03Z", 'C', 'B', 100.0, 10, 1));
+    tf.assert_equal(book.lastChange().depth(), 0, "Cancel at the top should report depth 0");
+
+    // Sample file: change-only rows are the changed rows of the full output, renumbered
+    std::vector<MBORecord> records = CSVParser::parseFile("../data/mbo.csv");
+    BookManager all_books;
+    BookManager change_books;
+    std::ostringstream expected;
+    std::ostringstream actual;
+    long row_index = 0;
+    for (const MBORecord& record : records) {
+        BookEntry& all_entry = all_books.route(record);
+        all_entry.book.processRecord(record);
+        std::string_view fields = all_entry.formatter.formatFields(record, all_entry.book);
+        BookEntry& change_entry = change_books.route(record);
+        change_entry.book.processRecord(record);
+        if (emitsRow(EmitMode::BookChanges, record, change_entry.book)) {
+            expected << row_index << ',' << fields;
+            std::string_view row = change_entry.formatter.formatRow(record, row_index++, change_entry.book);
+            actual.write(row.data(), row.size());
+        }
+    }
+    tf.assert_true(row_index > 0 && row_index < static_cast<long>(records.size()),
+                   "Change-only mode should skip records invisible at depth 10");
+    tf.assert_true(actual.str() == expected.str(), "Skipped rows should not disturb the cached level texts");
+
+    MBOReader reader;
+    reader.open("../data/mbo.csv");
+    ParallelReplay replay(3, 100, EmitMode::BookChanges);
+    std::ostringstream parallel;
+    size_t rows = replay.run(reader, parallel);
+    tf.assert_true(rows == static_cast<size_t>(row_index) && replay.recordsRead() == records.size() &&
+                   parallel.str() == expected.str(), "Parallel change-only rows should match and be numbered consecutively");
+}
+
+// Test view depths and MBP-1 / MBP-50 formatting from one book
+void test_book_depths(TestFramework& tf) {
+    std::cout << "\n=== Testing Configurable Book Depth ===" << std::endl;
+
+    OrderBook shallow;
+    OrderBook deep;
+    shallow.setViewDepth(1);
+    deep.setViewDepth(MAX_BOOK_DEPTH);
+    tf.assert_true(shallow.viewDepth() == 1 && deep.viewDepth() == MAX_BOOK_DEPTH, "View depth should be settable");
+
+    uint64_t state = 777;
+    auto next_random = [&state]() {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        return state >> 33;
+    };
+
+    bool views_match = true;
+    std::vector<long> live;
+    for (int i = 0; i < 20000; ++i) {
+        MBORecord record;
+        if (live.empty() || next_random() % 2 == 0) {
+            char side = next_random() % 2 == 0 ? 'B' : 'A';
+            double price = side == 'B' ? 99.0 - (next_random() % 80) * 0.01 : 101.0 + (next_random() % 80) * 0.01;
+            record = createRecord("2025-01-01T10:00:00Z", "2025-01-01T10:00:00Z", 'A', side, price,
+                                  static_cast<int>(next_random() % 100) + 1, i + 1);
+            live.push_back(i + 1);
+        } else {
+            size_t pick = next_random() % live.size();
+            record = createRecord("2025-01-01T10:00:00Z", "2025-01-01T10:00:00Z", 'C', 'B', 0.0, 0, live[pick]);
+            live[pick] = live.back();
+            live.pop_back();
+        }
+        shallow.processRecord(record);
+        deep.processRecord(record);
+
+        // Both cached views must equal a ladder scan of their depth
+        auto bids = deep.getBidLevels(MAX_BOOK_DEPTH + 1);
+        auto asks = deep.getAskLevels(MAX_BOOK_DEPTH + 1);
+        const TopLevels& deep_bids = deep.topBids();
+        const TopLevels& deep_asks = deep.topAsks();
+        if (deep_bids.count != std::min<int>(MAX_BOOK_DEPTH, bids.size()) ||
+            deep_asks.count != std::min<int>(MAX_BOOK_DEPTH, asks.size()) ||
+            shallow.topBids().count != std::min<int>(1, bids.size()) ||
+            shallow.topAsks().count != std::min<int>(1, asks.size())) {
+            views_match = false;
+            continue;
+        }
+        for (int k = 0; k < deep_bids.count; ++k) {
+            if (deep_bids.levels[k].price != bids[k].price || deep_bids.levels[k].total_size != bids[k].total_size) views_match = false;
+        }
+        for (int k = 0; k < deep_asks.count; ++k) {
+            if (deep_asks.levels[k].price != asks[k].price || deep_asks.levels[k].total_size != asks[k].total_size) views_match = false;
+        }
+        if ((shallow.topBids().count && shallow.topBids().levels[0].price != bids[0].price) ||
+            (shallow.topAsks().count && shallow.topAsks().levels[0].price != asks[0].price)) {
+            views_match = false;
+        }
+    }
+    tf.assert_true(views_match, "Depth-1 and depth-50 views should match a full ladder scan");
+
+    // Deepening an existing book refills its view
+    shallow.setViewDepth(BOOK_DEPTH);
+    tf.assert_equal(shallow.topBids().count, std::min<int>(BOOK_DEPTH, shallow.getBidLevels(BOOK_DEPTH + 1).size()),
+                    "Deepened view should be refilled from the ladder");
+
+    // Headers and rows at each depth from the same books
+    auto columns = [](const std::string& text) { return std::count(text.begin(), text.end(), ',') + 1; };
+    std::ostringstream header1, header50;
+    writeMBPHeader(header1, 1);
+    writeMBPHeader(header50, MAX_BOOK_DEPTH);
+    tf.assert_true(columns(header1.str()) == 22 && columns(header50.str()) == 316, "Headers should have 16 + 6 * depth columns");
+
+    std::vector<MBORecord> records = CSVParser::parseFile("../data/mbo.csv");
+    BookManager books;
+    books.setViewDepth(MAX_BOOK_DEPTH);
+    BasicMBPFormatter<1> mbp1;
+    BasicMBPFormatter<MAX_BOOK_DEPTH> mbp50;
+    auto split = [](const std::string& row) {
+        std::vector<std::string> fields;
+        std::stringstream stream(row.substr(0, row.size() - 1));
+        std::string field;
+        while (std::getline(stream, field, ',')) fields.push_back(field);
+        return fields;
+    };
+    bool rows_match = true;
+    int bbo_rows = 0;
+    long row_index = 0;
+    for (const MBORecord& record : records) {
+        BookEntry& entry = books.route(record);
+        entry.book.processRecord(record);
+        std::string row10(entry.formatter.formatRow(record, row_index, entry.book));
+        std::string row1(mbp1.formatRow(record, row_index, entry.book));
+        std::string row50(mbp50.formatRow(record, row_index, entry.book));
+        row_index++;
+        if (emitsRow<1>(EmitMode::BookChanges, record, entry.book)) bbo_rows++;
+
+        // Same record columns (apart from rtype and depth) and the same leading levels
+        std::vector<std::string> f10 = split(row10), f1 = split(row1), f50 = split(row50);
+        if (f1.size() != 22 || f50.size() != 316 || f10.size() != 76) {
+            rows_match = false;
+            continue;
+        }
+        auto same_record = [&](const std::vector<std::string>& f) {
+            return std::equal(f.begin(), f.begin() + 3, f10.begin()) && std::equal(f.begin() + 4, f.begin() + 8, f10.begin() + 4) &&
+                   std::equal(f.begin() + 9, f.begin() + 14, f10.begin() + 9) && std::equal(f.end() - 2, f.end(), f10.end() - 2);
+        };
+        if (!same_record(f1) || !same_record(f50) || !std::equal(f1.begin() + 14, f1.begin() + 20, f10.begin() + 14) ||
+            !std::equal(f50.begin() + 14, f50.begin() + 74, f10.begin() + 14) || f1[3] != "1" || f50[3] != "10") {
+            rows_match = false;
+        }
+    }
+    tf.assert_true(rows_match, "MBP-1 and MBP-50 rows should agree with MBP-10 on the shared levels");
+
+    // A binary MBP-10 record of a book viewing 50 levels holds its top 10 and no more
+    struct {
+        BinaryMBPRecord record;
+        unsigned char guard[2 * (MAX_BOOK_DEPTH - BOOK_DEPTH) * sizeof(MBPLevel)];
+    } deep_record;
+    std::memset(deep_record.guard, 0xAB, sizeof(deep_record.guard));
+    OrderBook wide;
+    wide.setViewDepth(MAX_BOOK_DEPTH);
+    MBORecord last;
+    for (int i = 0; i < 2 * (BOOK_DEPTH + 5); ++i) {
+        char side = i % 2 == 0 ? 'B' : 'A';
+        double price = side == 'B' ? 99.0 - i * 0.01 : 101.0 + i * 0.01;
+        last = createRecord("2025-01-01T10:00:00Z", "2025-01-01T10:00:00Z", 'A', side, price, 5, i + 1);
+        wide.processRecord(last);
+    }
+    tf.assert_true(wide.topBids().count > BOOK_DEPTH && wide.topAsks().count > BOOK_DEPTH,
+                   "Deep book should view more than 10 levels per side");
+    makeMBPRecord(last, wide, last.symbol_id, deep_record.record);
+    bool guard_intact = std::all_of(std::begin(deep_record.guard), std::end(deep_record.guard),
+                                    [](unsigned char c) { return c == 0xAB; });
+    std::vector<char> deep_row(MBP_ROW_MAX_SIZE + 64);
+    size_t deep_length = formatMBPRecord(deep_record.record, 0, SymbolTable::global().name(last.symbol_id), deep_row.data());
+    MBPFormatter formatter10;
+    tf.assert_true(guard_intact && std::string(deep_row.data(), deep_length) == std::string(formatter10.formatRow(last, 0, wide)),
+                   "Binary record of a deep book should equal its MBP-10 row");
+    tf.assert_true(bbo_rows > 0 && bbo_rows < static_cast<int>(records.size()), "Fewer records should change the BBO than the book");
+}
+
+// Test interleaved T->F->C sequences and tracker expiry
+void test_trade_sequence_tracker(TestFramework& tf) {
+    std::cout << "\n=== Testing Trade Sequence Tracker ===" << std::endl;
+
+    // Aggressor sweeping two ask levels: T T F F C C with one sequence number
+    OrderBook book;
+    book.processRecord(createRecord("2025-01-01T09:30:00Z", "2025-01-01T09:30:00Z", 'A', 'A', 100.0, 10, 1));
+    book.processRecord(createRecord("2025-01-01T09:30:00Z", "2025-01-01T09:30:00Z", 'A', 'A', 100.01, 20, 2));
+    book.processRecord(createRecord("2025-01-01T09:30:00Z", "2025-01-01T09:30:00Z", 'A', 'A', 100.02, 30, 3));
+    book.processRecord(createRecord("2025-01-01T09:30:01Z", "2025-01-01T09:30:01Z", 'T', 'B', 100.0, 10, 0));
+    book.processRecord(createRecord("2025-01-01T09:30:01Z", "2025-01-01T09:30:01Z", 'T', 'B', 100.01, 20, 0));
+    tf.assert_equal(book.tradeSequences().inFlight(), 2, "Both trades should wait for their fills");
+    book.processRecord(createRecord("2025-01-01T09:30:01Z", "2025-01-01T09:30:01Z", 'F', 'A', 100.0, 10, 1));
+    book.processRecord(createRecord("2025-01-01T09:30:01Z", "2025-01-01T09:30:01Z", 'F', 'A', 100.01, 20, 2));
+    tf.assert_equal(book.getAskLevels().size(), 3, "Fills alone should not change the book");
+
+    // Cancels arrive in the other order
+    book.processRecord(createRecord("2025-01-01T09:30:01Z", "2025-01-01T09:30:01Z", 'C', 'A', 100.01, 20, 2));
+    tf.assert_true(book.lastChange().any() && book.tradeSequences().inFlight() == 1, "Second sequence should complete first");
+    book.processRecord(createRecord("2025-01-01T09:30:01Z", "2025-01-01T09:30:01Z", 'C', 'A', 100.0, 10, 1));
+    auto asks = book.getAskLevels();
+    tf.assert_true(asks.size() == 1 && priceToDouble(asks[0].price) == 100.02 && book.tradeSequences().inFlight() == 0,
+                   "Interleaved sequences should both complete");
+
+    // Fills match waiting trades by sequence number, oldest first
+    TradeSequenceTracker tracker;
+    MBORecord trade_a = createRecord("2025-01-01T09:30:02Z", "2025-01-01T09:30:02Z", 'T', 'B', 100.0, 5, 0);
+    MBORecord trade_b = trade_a;
+    trade_b.sequence = trade_a.sequence + 1;
+    MBORecord fill_b = createRecord("2025-01-01T09:30:02Z", "2025-01-01T09:30:02Z", 'F', 'A', 100.0, 5, 42);
+    fill_b.sequence = trade_b.sequence;
+    MBORecord stray = fill_b;
+    stray.sequence = trade_b.sequence + 1;
+    tracker.onTrade(trade_a);
+    tracker.onTrade(trade_b);
+    tf.assert_true(tracker.onFill(fill_b) && !tracker.onFill(stray), "Fill should need a trade with its sequence");
+    TradeSequenceTracker::Fill fill;
+    MBORecord cancel = createRecord("2025-01-01T09:30:02Z", "2025-01-01T09:30:02Z", 'C', 'A', 100.0, 5, 42);
+    MBORecord plain = createRecord("2025-01-01T09:30:02Z", "2025-01-01T09:30:02Z", 'C', 'A', 100.0, 5, 43);
+    tf.assert_true(!tracker.onCancel(plain, fill) && tracker.onCancel(cancel, fill) && fill.order_id == 42 && fill.side == 'A',
+                   "Only the filled order's cancel should complete the sequence");
+
+    // Orphaned trades are bounded by the capacity and expire
+    for (int i = 0; i < 3 * TradeSequenceTracker::CAPACITY; ++i) {
+        tracker.onTrade(trade_a);
+    }
+    tf.assert_equal(tracker.inFlight(), TradeSequenceTracker::CAPACITY, "Orphaned trades should not exceed the capacity");
+    for (uint32_t i = 0; i <= TradeSequenceTracker::EXPIRY_RECORDS + 64; ++i) {
+        tracker.tick();
+    }
+    tf.assert_true(tracker.inFlight() == 0 && tracker.expired() >= 3 * TradeSequenceTracker::CAPACITY,
+                   "Stale trades should expire");
+}
+
+// Test native modify handling
+void test_modify_orders(TestFramework& tf) {
+    std::cout << "\n=== Testing Modify Orders ===" << std::endl;
+
+    OrderBook book;
+    book.processRecord(createRecord("2025-01-01T10:00:00Z", "2025-01-01T10:00:00Z", 'A', 'B', 100.0, 100, 1));
+    book.processRecord(createRecord("2025-01-01T10:00:00Z", "2025-01-01T10:00:00Z", 'A', 'B', 100.0, 50, 2));
+    book.processRecord(createRecord("2025-01-01T10:00:00Z", "2025-01-01T10:00:00Z", 'A', 'B', 99.0, 10, 3));
+
+    // Size reduction and increase at the same price
+    book.processRecord(createRecord("2025-01-01T10:00:01Z", "2025-01-01T10:00:01Z", 'M', 'B', 100.0, 60, 1));
+    auto bids = book.getBidLevels();
+    tf.assert_true(bids[0].total_size == 110 && bids[0].order_count == 2, "Size reduction should adjust the level in place");
+    tf.assert_true(book.lastChange().bid_mask == 1, "Size change should mark only its level");
+    book.processRecord(createRecord("2025-01-01T10:00:02Z", "2025-01-01T10:00:02Z", 'M', 'B', 100.0, 80, 1));
+    tf.assert_equal(book.getBidLevels()[0].total_size, 130, "Size increase should adjust the level in place");
+
+    // Price change moves the order between levels, creating and emptying levels
+    book.processRecord(createRecord("2025-01-01T10:00:03Z", "2025-01-01T10:00:03Z", 'M', 'B', 101.0, 80, 1));
+    bids = book.getBidLevels();
+    tf.assert_true(bids.size() == 3 && priceToDouble(bids[0].price) == 101.0 && bids[0].total_size == 80 &&
+                   bids[1].total_size == 50 && bids[1].order_count == 1, "Price change should move the order to a new level");
+    book.processRecord(createRecord("2025-01-01T10:00:04Z", "2025-01-01T10:00:04Z", 'M', 'B', 99.0, 5, 2));
+    bids = book.getBidLevels();
+    tf.assert_true(bids.size() == 2 && priceToDouble(bids[1].price) == 99.0 && bids[1].total_size == 15 &&
+                   bids[1].order_count == 2, "Moving the last order should remove its old level");
+
+    // Moved orders cancel from their new level
+    book.processRecord(createRecord("2025-01-01T10:00:05Z", "2025-01-01T10:00:05Z", 'C', 'B', 101.0, 80, 1));
+    bids = book.getBidLevels();
+    tf.assert_true(bids.size() == 1 && bids[0].total_size == 15, "Cancel should remove the modified order");
+
+    // Unknown order, zero size and side change
+    book.processRecord(createRecord("2025-01-01T10:00:06Z", "2025-01-01T10:00:06Z", 'M', 'A', 102.0, 40, 9));
+    tf.assert_true(book.getAskLevels().size() == 1 && book.getAskLevels()[0].total_size == 40, "Modify of an unknown order should add it");
+    book.processRecord(createRecord("2025-01-01T10:00:07Z", "2025-01-01T10:00:07Z", 'M', 'A', 102.0, 0, 9));
+    tf.assert_true(book.getAskLevels().empty(), "Modify to zero size should remove the order");
+    book.processRecord(createRecord("2025-01-01T10:00:07Z", "2025-01-01T10:00:07Z", 'M', 'A', 102.0, 0, 20));
+    book.processRecord(createRecord("2025-01-01T10:00:07Z", "2025-01-01T10:00:07Z", 'A', 'A', 102.0, 7, 21));
+    book.processRecord(createRecord("2025-01-01T10:00:07Z", "2025-01-01T10:00:07Z", 'C', 'A', 102.0, 0, 20));
+    tf.assert_true(book.getAskLevels().size() == 1 && book.getAskLevels()[0].total_size == 7 &&
+                   book.getAskLevels()[0].order_count == 1, "Zero-size modify of an unknown order should not track it");
+    book.processRecord(createRecord("2025-01-01T10:00:07Z", "2025-01-01T10:00:07Z", 'C', 'A', 102.0, 7, 21));
+    book.processRecord(createRecord("2025-01-01T10:00:08Z", "2025-01-01T10:00:08Z", 'M', 'A', 103.0, 5, 3));
+    tf.assert_true(book.getBidLevels()[0].total_size == 5 && book.getAskLevels()[0].total_size == 5,
+                   "Side change should move the order to the other side");
+
+    // Modify replay equals cancel + add replay
+    OrderBook modified;
+    OrderBook replaced;
+    uint64_t state = 99;
+    auto next_random = [&state]() {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        return state >> 33;
+    };
+    std::vector<MBORecord> live;
+    bool same_books = true;
+    for (int i = 0; i < 20000; ++i) {
+        if (live.empty() || next_random() % 3 == 0) {
+            char side = next_random() % 2 == 0 ? 'B' : 'A';
+            double price = side == 'B' ? 99.0 - (next_random() % 40) * 0.01 : 101.0 + (next_random() % 40) * 0.01;
+            MBORecord add = createRecord("2025-01-01T10:00:00Z", "2025-01-01T10:00:00Z", 'A', side, price,
+                                         static_cast<int>(next_random() % 100) + 1, i + 1);
+            modified.processRecord(add);
+            replaced.processRecord(add);
+            live.push_back(add);
+            continue;
+        }
+        MBORecord& order = live[next_random() % live.size()];
+        MBORecord modify = order;
+        modify.action = 'M';
+        modify.size = static_cast<int>(next_random() % 100) + 1;
+        if (next_random() % 2 == 0) {
+            modify.price += (static_cast<int64_t>(next_random() % 11) - 5) * DEFAULT_TICK_SIZE;
+        }
+        modified.processRecord(modify);
+        MBORecord cancel = order;
+        cancel.action = 'C';
+        MBORecord add = modify;
+        add.action = 'A';
+        replaced.processRecord(cancel);
+        replaced.processRecord(add);
+        order = add;
+
+        auto a = modified.getBidLevels(BOOK_DEPTH + 5);
+        auto b = replaced.getBidLevels(BOOK_DEPTH + 5);
+        auto c = modified.getAskLevels(BOOK_DEPTH + 5);
+        auto d = replaced.getAskLevels(BOOK_DEPTH + 5);
+        if (a.size() != b.size() || c.size() != d.size()) {
+            same_books = false;
+            continue;
+        }
+        for (size_t k = 0; k < a.size(); ++k) {
+            if (a[k].price != b[k].price || a[k].total_size != b[k].total_size || a[k].order_count != b[k].order_count) same_books = false;
+        }
+        for (size_t k = 0; k < c.size(); ++k) {
+            if (c[k].price != d[k].price || c[k].total_size != d[k].total_size || c[k].order_count != d[k].order_count) same_books = false;
+        }
     }
+    tf.assert_true(same_books, "Modify should leave the same levels as cancel followed by add");
+}
+
+// Test the synthetic MBO generator: reproducible, well-formed and replayable
+void test_mbo_generator(TestFramework& tf) {
+    std::cout << "\n=== Testing MBO Generator ===" << std::endl;
+
+    GeneratorOptions options;
+    options.seed = 7;
+    options.instruments = 1;
+    options.events = 50000;
+    options.cancel_rate = 1;   // about 990 live orders
+    options.trade_ratio = 0.05;
+    options.levels = 20;
+
+    // Same seed, same stream; another seed, another stream
+    auto render = [](GeneratorOptions generator_options, size_t count) {
+        MBOGenerator generator(generator_options);
+        TimestampCodec timestamps;
+        char line[MBO_LINE_MAX];
+        std::string text;
+        MBORecord record;
+        for (size_t i = 0; i < count && generator.next(record); ++i) {
+            text.append(line, formatMBOLine(record, timestamps, line));
+        }
+        return text;
+    };
+    tf.assert_true(render(options, 5000) == render(options, 5000), "Generator should be reproducible for a seed");
+    GeneratorOptions other = options;
+    other.seed = 8;
+    tf.assert_true(render(options, 5000) != render(other, 5000), "Different seeds should give different streams");
+
+    // Replay: every cancel and fill names a live order, so the book holds exactly the generator's live orders
+    MBOGenerator generator(options);
+    OrderBook book;
+    TimestampCodec timestamps;
+    char line[MBO_LINE_MAX];
+    std::vector<MBORecord> records;
+    MBORecord record;
+    bool round_trip = true;
+    while (generator.next(record)) {
+        book.processRecord(record);
+        records.push_back(record);
+
+        MBORecord parsed;
+        size_t length = formatMBOLine(record, timestamps, line);
+        if (CSVParser::parseLine(std::string_view(line, length - 1), parsed) != ParseError::None ||
+            parsed.ts_recv != record.ts_recv || parsed.ts_event != record.ts_event || parsed.action != record.action ||
+            parsed.side != record.side || parsed.price != record.price || parsed.size != record.size ||
+            parsed.order_id != record.order_id || parsed.sequence != record.sequence ||
+            parsed.instrument_id != record.instrument_id || parsed.symbol_id != record.symbol_id) {
+            round_trip = false;
+        }
+    }
+    tf.assert_true(records.size() == options.events && generator.recordsGenerated() == options.events,
+                   "Generator should stop after the requested event count");
+    tf.assert_true(records[0].action == 'R', "Stream should start with a reset");
+    tf.assert_true(round_trip, "Generated CSV lines should parse back to the same records");
+
+    uint64_t triples = 0;
+    bool well_formed = true;
+    for (size_t i = 0; i < records.size(); ++i) {
+        if (records[i].action != 'T') continue;
+        if (i + 2 >= records.size() || records[i + 1].action != 'F' || records[i + 2].action != 'C' ||
+            records[i + 1].sequence != records[i].sequence || records[i + 2].order_id != records[i + 1].order_id ||
+            records[i].side == records[i + 1].side) {
+            well_formed = false;
+        }
+        triples++;
+    }
+    tf.assert_true(well_formed && triples == generator.tradesGenerated() && triples > 0,
+                   "Trades should be emitted as T, F, C triples");
+
+    auto bids = book.getBidLevels(MAX_BOOK_DEPTH);
+    auto asks = book.getAskLevels(MAX_BOOK_DEPTH);
+    size_t book_orders = 0;
+    for (const auto& level : bids) book_orders += level.order_count;
+    for (const auto& level : asks) book_orders += level.order_count;
+    tf.assert_true(book_orders == generator.liveOrders() && book_orders > 500,
+                   "Replayed book should hold the generator's live orders");
+    tf.assert_true(!bids.empty() && !asks.empty() && bids[0].price < asks[0].price, "Generated book should not cross");
+    tf.assert_equal(static_cast<int>(book.tradeSequences().inFlight()), 0, "No trade sequence should be left open");
+
+    // Instruments get their own books
+    options.instruments = 5;
+    options.events = 5000;
+    MBOGenerator multi(options);
+    BookManager books;
+    while (multi.next(record)) {
+        books.route(record).book.processRecord(record);
+    }
+    tf.assert_equal(static_cast<int>(books.size()), 5, "Each instrument should get its own book");
+}
+
+// Test the latency histograms behind the MBO_INSTRUMENT switch
+void test_latency_histogram(TestFramework& tf) {
+    std::cout << "\n=== Testing Latency Histogram ===" << std::endl;
+    using latency::LatencyHistogram;
+
+    // Every value falls in the bucket whose bounds enclose it, within 12.5%
+    bool bounded = true;
+    for (uint64_t value : {0ULL, 1ULL, 15ULL, 16ULL, 17ULL, 100ULL, 1000ULL, 123456789ULL, 1ULL << 40, ~0ULL}) {
+        int bucket = LatencyHistogram::bucketOf(value);
+        uint64_t low = LatencyHistogram::bucketLow(bucket);
+        uint64_t next = bucket + 1 < LatencyHistogram::BUCKETS ? LatencyHistogram::bucketLow(bucket + 1) : ~0ULL;
+        if (bucket < 0 || bucket >= LatencyHistogram::BUCKETS || value < low || (value >= next && next != ~0ULL) ||
+            static_cast<double>(next - low) > 0.125 * static_cast<double>(low) + 1) {
+            bounded = false;
+        }
+    }
+    tf.assert_true(bounded, "Buckets should enclose their values with 12.5% resolution");
+
+    auto histogram = std::make_unique<LatencyHistogram>();
+    for (uint64_t value = 1; value <= 10000; ++value) {
+        histogram->record(value);
+    }
+    auto near = [](uint64_t actual, double expected) { return std::abs(static_cast<double>(actual) - expected) <= 0.07 * expected; };
+    tf.assert_true(near(histogram->percentile(0.50), 5000) && near(histogram->percentile(0.99), 9900) &&
+                   histogram->max() == 10000 && histogram->mean() == 5000.5,
+                   "Percentiles of a uniform range should be close to exact");
+
+    auto other = std::make_unique<LatencyHistogram>();
+    other->record(50000);
+    histogram->merge(*other);
+    tf.assert_true(histogram->count() == 10001 && histogram->max() == 50000 && histogram->percentile(1.0) == 50000,
+                   "Merge should combine counts and maxima");
+
+    // All events counted, the first SAMPLE_ALL timed, then one in SAMPLE_EVERY
+    histogram->reset();
+    uint64_t timed = 0;
+    const uint64_t events = latency::SAMPLE_ALL + 100 * latency::SAMPLE_EVERY;
+    for (uint64_t i = 0; i < events; ++i) {
+        if (histogram->due()) {
+            histogram->record(10);
+            timed++;
+        }
+    }
+    tf.assert_true(histogram->eventCount() == events && timed == latency::SAMPLE_ALL + 100,
+                   "Sampling should time the warm-up and then one event in SAMPLE_EVERY");
+
+    std::string filename = "../build/test_latency_stats.json";
+    tf.assert_true(latency::writeLatencyJson(filename), "Latency summary should be written");
+    std::ifstream input(filename);
+    std::string json((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+    tf.assert_true(json.find("\"stages\"") != std::string::npos && json.find("\"trade_cancel\"") != std::string::npos &&
+                   json.find("\"orders_live\"") != std::string::npos, "Summary should list stages, actions and counters");
+    std::remove(filename.c_str());
+}
+
+// Test checkpoint save/restore and the resume hooks of the reader and writer
+void test_checkpoint(TestFramework& tf) {
+    std::cout << "\n=== Testing Checkpoint and Restart ===" << std::endl;
+
+    // Replay a synthetic stream, checkpoint right after a fill (its trade
+    // sequence still in flight), and continue both the original and the
+    // restored books
+    GeneratorOptions options;
+    options.seed = 11;
+    options.instruments = 3;
+    options.events = 20000;
+    options.trade_ratio = 0.05;
+    MBOGenerator generator(options);
+    std::vector<MBORecord> records;
+    MBORecord record;
+    while (generator.next(record)) {
+        records.push_back(record);
+    }
+    size_t split = 10000;
+    while (split < records.size() && records[split - 1].action != 'F') {
+        split++;
+    }
+
+    BookManager original;
+    for (size_t i = 0; i < split; ++i) {
+        original.route(records[i]).book.processRecord(records[i]);
+    }
+
+    const std::string filename = "../build/test_checkpoint.bin";
+    CheckpointPosition saved;
+    saved.records = split;
+    saved.input_offset = 12345;
+    saved.sequence = records[split - 1].sequence;
+    saved.ts_recv = records[split - 1].ts_recv;
+    saved.outputs.push_back(CheckpointOutput{BOOK_DEPTH, 0, 42, 4096});
+    tf.assert_true(writeCheckpoint(filename, original, saved), "Checkpoint should be written");
+
+    BookManager restored;
+    CheckpointPosition loaded;
+    tf.assert_true(readCheckpoint(filename, restored, loaded), "Checkpoint should be read back");
+    tf.assert_true(loaded.records == split && loaded.input_offset == 12345 && loaded.sequence == saved.sequence &&
+                   loaded.ts_recv == saved.ts_recv && loaded.outputs.size() == 1 && loaded.outputs[0].rows == 42 &&
+                   loaded.outputs[0].bytes == 4096, "Position should round-trip");
+
+    auto sameBooks = [&]() {
+        if (original.size() != restored.size()) return false;
+        auto a = original.begin();
+        auto b = restored.begin();
+        for (; a != original.end(); ++a, ++b) {
+            std::vector<PriceLevel> bids_a = a->book.getBidLevels(MAX_BOOK_DEPTH);
+            std::vector<PriceLevel> bids_b = b->book.getBidLevels(MAX_BOOK_DEPTH);
+            std::vector<PriceLevel> asks_a = a->book.getAskLevels(MAX_BOOK_DEPTH);
+            std::vector<PriceLevel> asks_b = b->book.getAskLevels(MAX_BOOK_DEPTH);
+            if (a->instrument_id != b->instrument_id || a->symbol_id != b->symbol_id ||
+                a->book.orderTableStats().size != b->book.orderTableStats().size ||
+                a->book.tradeSequences().inFlight() != b->book.tradeSequences().inFlight() ||
+                bids_a.size() != bids_b.size() || asks_a.size() != asks_b.size()) {
+                return false;
+            }
+            for (size_t i = 0; i < bids_a.size(); ++i) {
+                if (bids_a[i].price != bids_b[i].price || bids_a[i].total_size != bids_b[i].total_size ||
+                    bids_a[i].order_count != bids_b[i].order_count) return false;
+            }
+            for (size_t i = 0; i < asks_a.size(); ++i) {
+                if (asks_a[i].price != asks_b[i].price || asks_a[i].total_size != asks_b[i].total_size ||
+                    asks_a[i].order_count != asks_b[i].order_count) return false;
+            }
+        }
+        return true;
+    };
+    tf.assert_true(sameBooks(), "Restored books should match the checkpointed books");
+    BookEntry* filled = restored.find(records[split - 1].publisher_id, records[split - 1].instrument_id);
+    tf.assert_true(filled && filled->book.tradeSequences().inFlight() > 0, "In-flight trade sequence should be restored");
+
+    for (size_t i = split; i < records.size(); ++i) {
+        original.route(records[i]).book.processRecord(records[i]);
+        restored.route(records[i]).book.processRecord(records[i]);
+    }
+    tf.assert_true(sameBooks(), "Replay after a restore should end in the same books");
+
+    std::ofstream(filename, std::ios::binary | std::ios::trunc) << "not a checkpoint";
+    tf.assert_true(!readCheckpoint(filename, restored, loaded), "Corrupt checkpoint should be rejected");
+    std::remove(filename.c_str());
+
+    // position() and seek() let a reader continue where another stopped
+    for (ReadMode mode : {ReadMode::Mapped, ReadMode::Streaming}) {
+        MBOReader reader;
+        tf.assert_true(reader.open("../data/test_data.csv", mode, 160), "Reader should open test file");
+        MBORecord third;
+        reader.next(record);
+        reader.next(record);
+        uint64_t offset = reader.position();
+        reader.next(third);
+        tf.assert_true(reader.open("../data/test_data.csv", mode, 160) && reader.seek(offset) &&
+                       reader.next(record) && sameRecord(record, third), "Seek should return to the saved record");
+    }
+
+    // A flushed writer leaves every appended byte in the file; a resumed one
+    // cuts the file back to the kept bytes and appends after them
+    const std::string output_file = "../build/test_checkpoint.out";
+    auto readAll = [&]() {
+        std::ifstream input(output_file, std::ios::binary);
+        std::ostringstream content;
+        content << input.rdbuf();
+        return content.str();
+    };
+    std::string rows;
+    for (int i = 0; i < 3000; ++i) {
+        rows += "row " + std::to_string(i) + "\n";
+    }
+    for (bool direct : {false, true}) {
+        AsyncWriter::Options writer_options;
+        writer_options.buffer_size = 4096;
+        writer_options.direct_io = direct;
+        AsyncWriter writer;
+        writer.open(output_file, writer_options);
+        writer.append(rows.substr(0, 10000));
+        tf.assert_true(writer.flush() && readAll().substr(0, 10000) == rows.substr(0, 10000),
+                       "Flush should write every appended byte");
+        writer.append(rows.substr(10000));
+        writer.append("lost after the checkpoint\n");
+        writer.close();
+
+        writer_options.keep_bytes = 10000;
+        tf.assert_true(writer.open(output_file, writer_options), "Writer should resume the existing file");
+        writer.append(rows.substr(10000));
+        tf.assert_true(writer.close() && readAll() == rows, "Resumed output should continue after the kept bytes");
+    }
+    AsyncWriter::Options too_long;
+    too_long.keep_bytes = rows.size() + 1;
+    AsyncWriter writer;
+    tf.assert_true(!writer.open(output_file, too_long), "Resuming beyond the end of the file should fail");
+    std::remove(output_file.c_str());
+}
+
+// Test point-in-time queries from a replay index against full replays
+void test_replay_index(TestFramework& tf) {
+    std::cout << "\n=== Testing Replay Index ===" << std::endl;
+
+    GeneratorOptions options;
+    options.seed = 5;
+    options.instruments = 2;
+    options.events = 20000;
+    options.trade_ratio = 0.05;
+    MBOGenerator generator(options);
+    std::vector<MBORecord> records;
+    MBORecord record;
+    const std::string input_file = "../build/test_replay_index.csv";
+    {
+        std::ofstream output(input_file, std::ios::binary);
+        output << MBO_CSV_HEADER;
+        TimestampCodec timestamps;
+        char line[MBO_LINE_MAX];
+        while (generator.next(record)) {
+            records.push_back(record);
+            output.write(line, formatMBOLine(record, timestamps, line));
+        }
+    }
+
+    const std::string index_file = "../build/test_replay_index.idx";
+    IndexOptions index_options;
+    index_options.every_records = 3000;
+    index_options.every_ns = 500000000;
+    uint64_t indexed = 0;
+    uint32_t snapshots = 0;
+    tf.assert_true(buildReplayIndex(input_file, index_file, index_options, &indexed, &snapshots),
+                   "Index should be built");
+    tf.assert_true(indexed == records.size() && snapshots > records.size() / 3000,
+                   "Index should cover every record with periodic snapshots");
+
+    ReplayIndex index;
+    tf.assert_true(index.open(index_file, input_file), "Index should open against its input");
+
+    // MBP-10 rows of the book at t by replaying from the first record
+    auto expectedRows = [&](int64_t t) {
+        BookManager books;
+        std::vector<size_t> last;
+        for (size_t i = 0; i < records.size() && records[i].ts_event <= t; ++i) {
+            BookEntry& entry = books.route(records[i]);
+            entry.book.processRecord(records[i]);
+            last.resize(std::max(last.size(), static_cast<size_t>(entry.index) + 1));
+            last[entry.index] = i;
+        }
+        std::string rows;
+        for (BookEntry& entry : books) {
+            rows += entry.formatter.formatRow(records[last[entry.index]], static_cast<long>(last[entry.index]), entry.book);
+        }
+        return rows;
+    };
+
+    bool all_match = true;
+    bool gaps_bounded = true;
+    BookManager books;
+    std::vector<IndexedBookState> last;
+    int64_t first = records.front().ts_event;
+    int64_t span = records.back().ts_event - first;
+    for (int64_t t : {first - 1, first, first + span / 7, first + span / 2, first + span * 5 / 6, first + span + 1}) {
+        if (!index.query(t, books, last)) {
+            all_match = false;
+            continue;
+        }
+        std::string rows;
+        for (BookEntry& entry : books) {
+            rows += entry.formatter.formatRow(last[entry.index].record, static_cast<long>(last[entry.index].record_index),
+                                              entry.book);
+        }
+        all_match = all_match && rows == expectedRows(t);
+        gaps_bounded = gaps_bounded && index.lastGap() <= 3000;
+    }
+    tf.assert_true(all_match, "Query rows should equal those of a full replay up to the same time");
+    tf.assert_true(gaps_bounded, "Queries should replay at most one snapshot interval");
+
+    std::ofstream(input_file, std::ios::app) << "\n";
+    tf.assert_true(!index.open(index_file, input_file), "Index should refuse a changed input");
+
+    std::remove(input_file.c_str());
+    std::remove(index_file.c_str());
+}
+
+// Test live ingest from a pipe and a UNIX socket against parsing the same lines from a file
+void test_live_ingest(TestFramework& tf) {
+    std::cout << "\n=== Testing Live Ingest ===" << std::endl;
+
+    GeneratorOptions options;
+    options.seed = 9;
+    options.events = 3000;
+    MBOGenerator generator(options);
+    std::string feed(MBO_CSV_HEADER);
+    std::vector<std::string> expected;
+    TimestampCodec timestamps;
+    char line[MBO_LINE_MAX];
+    MBORecord record;
+    while (generator.next(record)) {
+        size_t length = formatMBOLine(record, timestamps, line);
+        expected.emplace_back(line, length);
+        feed.append(line, length);
+        if (expected.size() == 1000) {
+            feed += "not,a,record\n";
+        }
+    }
+
+    // Send the feed in uneven pieces so that lines straddle reads
+    auto sendFeed = [&feed](int descriptor) {
+        for (size_t offset = 0, piece = 1; offset < feed.size(); offset += piece, piece = piece * 7 % 4093 + 1) {
+            size_t size = std::min(piece, feed.size() - offset);
+            if (::write(descriptor, feed.data() + offset, size) != static_cast<ssize_t>(size)) break;
+            if (piece % 5 == 0) std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+        ::close(descriptor);
+    };
+
+    // Every record up to End, formatted back into lines; small ring to exercise backpressure
+    auto drain = [&](LiveIngest& ingest, std::vector<std::string>& lines) {
+        if (!ingest.start(64)) return false;
+        LiveIngest::Item item;
+        TimestampCodec codec;
+        LiveIngest::Poll state;
+        while ((state = ingest.poll(item)) != LiveIngest::Poll::End) {
+            if (state == LiveIngest::Poll::Record) {
+                lines.emplace_back(line, formatMBOLine(item.record, codec, line));
+                if (item.received_ns > LiveIngest::nowNs()) return false;
+            }
+        }
+        return true;
+    };
+
+    int pipe_fds[2];
+    tf.assert_true(::pipe(pipe_fds) == 0, "Pipe should open");
+    LiveIngest from_pipe;
+    tf.assert_true(from_pipe.openDescriptor(pipe_fds[0]), "Ingest should accept a pipe");
+    std::thread pipe_writer(sendFeed, pipe_fds[1]);
+    std::vector<std::string> pipe_lines;
+    bool drained = drain(from_pipe, pipe_lines);
+    pipe_writer.join();
+    tf.assert_true(drained && pipe_lines == expected, "Pipe records should equal the generated ones in order");
+    tf.assert_equal(static_cast<int>(from_pipe.stats().errors), 1, "Malformed line should be counted");
+    tf.assert_equal(static_cast<int>(from_pipe.stats().first_error_line), 1002, "Error line should count the header");
+    from_pipe.close();
+
+    const std::string socket_path = "../build/test_live_ingest.sock";
+    LiveIngest from_socket;
+    tf.assert_true(from_socket.listenSocket(socket_path), "Ingest should listen on a UNIX socket");
+    std::thread socket_writer([&]() {
+        int descriptor = -1;
+        for (int attempt = 0; attempt < 100 && descriptor < 0; ++attempt) {
+            descriptor = connectLiveSocket(socket_path);
+        }
+        if (descriptor >= 0) sendFeed(descriptor);
+    });
+    std::vector<std::string> socket_lines;
+    drained = drain(from_socket, socket_lines);
+    socket_writer.join();
+    tf.assert_true(drained && socket_lines == expected, "Socket records should equal the generated ones in order");
+    from_socket.close();
+    tf.assert_true(::access(socket_path.c_str(), F_OK) != 0, "Socket file should be removed on close");
+}
+
+// Test the cached timestamp codec against the general conversions
+void test_timestamp_codec(TestFramework& tf) {
+    std::cout << "\n=== Testing Timestamp Codec ===" << std::endl;
+
+    TimestampCodec codec;
+    char expected[TIMESTAMP_LENGTH];
+    char actual[TIMESTAMP_LENGTH];
+
+    // Steps that cross seconds, hours, days, years and the epoch
+    bool all_match = true;
+    int64_t ns = 1752739503360677248LL;
+    for (int i = 0; i < 20000; ++i) {
+        ns += (i % 7 == 0) ? -3599999999999LL : 987654321987LL;
+        if (i == 10000) ns = -5000000000000LL;
+        formatTimestamp(ns, expected);
+        codec.format(ns, actual);
+        int64_t parsed = 0;
+        if (std::string(expected, TIMESTAMP_LENGTH) != std::string(actual, TIMESTAMP_LENGTH) ||
+            !codec.parse(std::string_view(actual, TIMESTAMP_LENGTH), parsed) || parsed != ns) {
+            all_match = false;
+        }
+    }
+    tf.assert_true(all_match, "Codec should match the general parse and format");
+
+    int64_t parsed = 0;
+    tf.assert_true(codec.parse("2025-07-17T08:05:03.360842448Z", parsed) && parsed == 1752739503360842448LL,
+                   "Codec should parse a sample timestamp");
+    tf.assert_true(codec.parse("2025-07-17T08:59:60.000000000Z", parsed) && codec.parse("2025-01-01T10:00:00Z", parsed) &&
+                   parsed == 1735725600000000000LL, "Leap seconds and short forms should parse");
+    tf.assert_true(!codec.parse("2025-07-17T08:60:03.360842448Z", parsed) &&
+                   !codec.parse("2025-07-17T08:05:03,360842448Z", parsed) &&
+                   !codec.parse("2025-07-17T08:05:03.36084244xZ", parsed) &&
+                   !codec.parse("2025-07-17T08:05:03.360842448 ", parsed) &&
+                   !codec.parse("2025-07-17X08:05:03.360842448Z", parsed),
+                   "Codec should reject malformed tails and prefixes");
 }
 
 // Test performance with large dataset
@@ -374,7 +2011,7 @@ void test_edge_cases(TestFramework& tf) {
     
     bid_levels = book.getBidLevels();
     tf.assert_equal(bid_levels.size(), 1, "Negative price order should still be processed");
-    tf.assert_equal(bid_levels[0].price, -100.0, "Negative price should be preserved");
+    tf.assert_equal(priceToDouble(bid_levels[0].price), -100.0, "Negative price should be preserved");
     
     // Test very large order ID
     auto large_id_record = createRecord("2025-01-01T10:00:02Z", "2025-01-01T10:00:02Z", 
@@ -436,7 +2073,7 @@ void test_reconstruction_pipeline(TestFramework& tf) {
     tf.assert_equal(ask_levels.size(), 1, "Should have one ask level after processing");
     
     if (ask_levels.size() >= 1) {
-        tf.assert_equal(ask_levels[0].price, 101.00, "Ask price should be 101.00");
+        tf.assert_equal(priceToDouble(ask_levels[0].price), 101.00, "Ask price should be 101.00");
         tf.assert_equal(ask_levels[0].total_size, 50, "Ask size should be 50");
     }
 }
@@ -455,6 +2092,29 @@ int main() {
     test_special_cases(tf);
     test_mbp_output(tf);
     test_csv_parsing(tf);
+    test_mbo_reader(tf);
+    test_streaming_reader(tf);
+    test_fixed_point_prices(tf);
+    test_price_ladder(tf);
+    test_order_table(tf);
+    test_top_levels_cache(tf);
+    test_mbp_formatter(tf);
+    test_book_manager(tf);
+    test_parallel_replay(tf);
+    test_binary_format(tf);
+    test_timestamp_codec(tf);
+    test_mbp_binary_output(tf);
+    test_parallel_parsing(tf);
+    test_async_writer(tf);
+    test_change_only_emission(tf);
+    test_book_depths(tf);
+    test_trade_sequence_tracker(tf);
+    test_modify_orders(tf);
+    test_mbo_generator(tf);
+    test_latency_histogram(tf);
+    test_checkpoint(tf);
+    test_replay_index(tf);
+    test_live_ingest(tf);
     test_performance(tf);
     test_edge_cases(tf);
     test_incomplete_sequences(tf);